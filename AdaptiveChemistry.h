@@ -0,0 +1,608 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+
+#ifndef NETSMOKE_ADAPTIVECHEMISTRY_H
+#define NETSMOKE_ADAPTIVECHEMISTRY_H
+
+#include <map>
+#include <queue>
+#include <vector>
+#include <cmath>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include "SparsePSRJacobian.h"
+#include "JacobianReuse.h"
+
+namespace NetSMOKE
+{
+	enum AdaptiveChemistryType { ADAPTIVE_CHEMISTRY_NONE, ADAPTIVE_CHEMISTRY_DRG, ADAPTIVE_CHEMISTRY_DRGEP };
+
+	inline AdaptiveChemistryType AdaptiveChemistryFromString(const std::string& method)
+	{
+		if (method == "None")			return ADAPTIVE_CHEMISTRY_NONE;
+		else if (method == "DRG")		return ADAPTIVE_CHEMISTRY_DRG;
+		else if (method == "DRGEP")		return ADAPTIVE_CHEMISTRY_DRGEP;
+		else OpenSMOKE::FatalErrorMessage("Unknown @AdaptiveChemistry: " + method + " (use None, DRG, DRGEP)");
+		return ADAPTIVE_CHEMISTRY_NONE;
+	}
+
+	//!  Directed relation graph of the species, weighted with the reaction rates of a given state
+	/*!
+		 DRG: r_AB = sum_j |nu_Aj w_j delta_Bj| / sum_j |nu_Aj w_j|, the species reachable from the
+		 targets through edges with r_AB > threshold are kept.
+		 DRGEP: r_AB = |sum_j nu_Aj w_j delta_Bj| / max(P_A, C_A) (P_A, C_A production and consumption
+		 rates of A), the species whose largest path product from a target is above the threshold
+		 are kept (max-product Dijkstra search).
+		 The graph structure depends only on the stoichiometry, the weights are computed on the fly.
+	*/
+	class DirectedRelationGraph
+	{
+	public:
+
+		DirectedRelationGraph(const MechanismStoichiometry& stoich) :
+			ns_(stoich.NumberOfSpecies()),
+			nr_(stoich.NumberOfReactions())
+		{
+			// Net stoichiometric coefficient of each species in each reaction
+			reaction_ptr_.assign(1, 0);
+			std::vector<double> nu(ns_, 0.);
+			std::vector<unsigned int> touched;
+			for (unsigned int j = 0; j < nr_; j++)
+			{
+				touched.clear();
+				for (unsigned int a = stoich.reactant_ptr[j]; a < stoich.reactant_ptr[j + 1]; a++)
+				{
+					touched.push_back(stoich.reactant_species[a]);
+					nu[stoich.reactant_species[a]] -= stoich.reactant_coefficients[a];
+				}
+				for (unsigned int a = stoich.product_ptr[j]; a < stoich.product_ptr[j + 1]; a++)
+				{
+					touched.push_back(stoich.product_species[a]);
+					nu[stoich.product_species[a]] += stoich.product_coefficients[a];
+				}
+				std::sort(touched.begin(), touched.end());
+				touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+				for (unsigned int a = 0; a < touched.size(); a++)
+				{
+					reaction_species_.push_back(touched[a]);
+					reaction_nu_.push_back(nu[touched[a]]);
+					nu[touched[a]] = 0.;
+				}
+				reaction_ptr_.push_back(static_cast<unsigned int>(reaction_species_.size()));
+			}
+
+			// Transpose: reactions of each species
+			species_ptr_.assign(ns_ + 1, 0);
+			for (unsigned int a = 0; a < reaction_species_.size(); a++)
+				species_ptr_[reaction_species_[a] + 1]++;
+			for (unsigned int i = 0; i < ns_; i++)
+				species_ptr_[i + 1] += species_ptr_[i];
+			species_reactions_.resize(reaction_species_.size());
+			species_nu_.resize(reaction_species_.size());
+			std::vector<unsigned int> position(species_ptr_.begin(), species_ptr_.end() - 1);
+			for (unsigned int j = 0; j < nr_; j++)
+				for (unsigned int a = reaction_ptr_[j]; a < reaction_ptr_[j + 1]; a++)
+				{
+					const unsigned int p = position[reaction_species_[a]]++;
+					species_reactions_[p] = j;
+					species_nu_[p] = reaction_nu_[a];
+				}
+
+			numerator_.assign(ns_, 0.);
+			listed_.assign(ns_, false);
+			score_.resize(ns_);
+		}
+
+		unsigned int NumberOfSpecies() const { return ns_; }
+		unsigned int NumberOfReactions() const { return nr_; }
+
+		//! Species of reaction j (CSR)
+		const std::vector<unsigned int>& ReactionPtr() const { return reaction_ptr_; }
+		const std::vector<unsigned int>& ReactionSpecies() const { return reaction_species_; }
+
+		//! Species needed to describe the targets at the state of the given forward and backward rates
+		void Reduce(const AdaptiveChemistryType type, const double* rf, const double* rb, const std::vector<unsigned int>& targets,
+					const double threshold, std::vector<bool>& active)
+		{
+			active.assign(ns_, false);
+			if (type == ADAPTIVE_CHEMISTRY_DRG)
+			{
+				std::vector<unsigned int> stack(targets);
+				for (unsigned int k = 0; k < targets.size(); k++)
+					active[targets[k]] = true;
+				while (stack.empty() == false)
+				{
+					const unsigned int A = stack.back();
+					stack.pop_back();
+					Interactions(type, A, rf, rb);
+					for (unsigned int k = 0; k < neighbours_.size(); k++)
+					{
+						const unsigned int B = neighbours_[k];
+						if (active[B] == false && numerator_[B] > threshold)
+						{
+							active[B] = true;
+							stack.push_back(B);
+						}
+						numerator_[B] = 0.;
+					}
+				}
+			}
+			else
+			{
+				std::fill(score_.begin(), score_.end(), 0.);
+				std::priority_queue< std::pair<double, unsigned int> > queue;
+				for (unsigned int k = 0; k < targets.size(); k++)
+				{
+					score_[targets[k]] = 1.;
+					queue.push(std::make_pair(1., targets[k]));
+				}
+				while (queue.empty() == false)
+				{
+					const double R = queue.top().first;
+					const unsigned int A = queue.top().second;
+					queue.pop();
+					if (active[A] == true || R < score_[A])
+						continue;
+					active[A] = true;
+
+					Interactions(type, A, rf, rb);
+					for (unsigned int k = 0; k < neighbours_.size(); k++)
+					{
+						const unsigned int B = neighbours_[k];
+						const double RB = R * numerator_[B];
+						if (active[B] == false && RB > threshold && RB > score_[B])
+						{
+							score_[B] = RB;
+							queue.push(std::make_pair(RB, B));
+						}
+						numerator_[B] = 0.;
+					}
+				}
+			}
+		}
+
+	private:
+
+		//! r_AB for all the species B sharing a reaction with A (stored in numerator_, each B listed once in neighbours_)
+		void Interactions(const AdaptiveChemistryType type, const unsigned int A, const double* rf, const double* rb)
+		{
+			neighbours_.clear();
+			double production = 0.;
+			double consumption = 0.;
+			for (unsigned int p = species_ptr_[A]; p < species_ptr_[A + 1]; p++)
+			{
+				const unsigned int j = species_reactions_[p];
+				const double v = species_nu_[p] * (rf[j] - rb[j]);
+				if (v > 0.)	production += v;
+				else		consumption -= v;
+
+				const double contribution = (type == ADAPTIVE_CHEMISTRY_DRG) ? std::fabs(v) : v;
+				for (unsigned int a = reaction_ptr_[j]; a < reaction_ptr_[j + 1]; a++)
+				{
+					const unsigned int B = reaction_species_[a];
+					if (B == A)
+						continue;
+					if (listed_[B] == false)
+					{
+						listed_[B] = true;
+						neighbours_.push_back(B);
+					}
+					numerator_[B] += contribution;
+				}
+			}
+
+			const double denominator = (type == ADAPTIVE_CHEMISTRY_DRG) ? production + consumption : std::max(production, consumption);
+			for (unsigned int k = 0; k < neighbours_.size(); k++)
+			{
+				const unsigned int B = neighbours_[k];
+				numerator_[B] = (denominator > 0.) ? std::fabs(numerator_[B]) / denominator : 0.;
+				listed_[B] = false;
+			}
+		}
+
+	private:
+
+		unsigned int ns_;
+		unsigned int nr_;
+
+		std::vector<unsigned int> reaction_ptr_;
+		std::vector<unsigned int> reaction_species_;
+		std::vector<double> reaction_nu_;
+
+		std::vector<unsigned int> species_ptr_;
+		std::vector<unsigned int> species_reactions_;
+		std::vector<double> species_nu_;
+
+		std::vector<double> numerator_;
+		std::vector<double> score_;
+		std::vector<unsigned int> neighbours_;
+		std::vector<bool> listed_;
+	};
+
+	//!  Kinetics of a subset of the species and reactions, on top of the full kinetics
+	/*!
+		 The species not included keep the mass fractions of the background (the reactor inlet:
+		 they do not react, so they flow through the reactor unchanged) and still contribute to
+		 the density, the specific heat and the concentrations seen by the full kinetics (i.e.
+		 third bodies). Their enthalpy is carried by the active species: each enthalpy is shifted
+		 by sum_inactive omega_i h_i(T) / sum_active omega_k (background fractions), so that the
+		 feed enthalpy seen by the energy balance is the one of the full inlet; the shift cancels
+		 in the heat release, since the reactions conserve the mass. As in the PSR solvers,
+		 Density is called before ReactionRates at the same state, which fixes the
+		 concentrations of the background species.
+		 Besides the interface of the SparsePSRSolver, the full kinetics must provide the rates
+		 of a subset of reactions:
+		 - void ReactionRates(T, P, const double* c, const std::vector<unsigned int>& reactions, double* rf, double* rb)
+	*/
+	template<typename MechanismKinetics>
+	class ReducedKinetics
+	{
+	public:
+
+		ReducedKinetics(MechanismKinetics& kinetics, const std::vector<double>& molecular_weights,
+						const std::vector<unsigned int>& species, const std::vector<unsigned int>& reactions) :
+			kinetics_(kinetics),
+			mw_(molecular_weights),
+			species_(species),
+			reactions_(reactions)
+		{
+			omega_.assign(mw_.size(), 0.);
+			background_.assign(mw_.size(), 0.);
+			c_.assign(mw_.size(), 0.);
+			h_.assign(mw_.size(), 0.);
+		}
+
+		void SetBackground(const double* omega)
+		{
+			std::copy(omega, omega + mw_.size(), background_.begin());
+			omega_ = background_;
+		}
+
+		double Density(const double T, const double P, const double* omega)
+		{
+			Scatter(omega);
+			const double rho = kinetics_.Density(T, P, &omega_[0]);
+			for (unsigned int i = 0; i < mw_.size(); i++)
+				c_[i] = rho * background_[i] / mw_[i];
+			return rho;
+		}
+
+		void ReactionRates(const double T, const double P, const double* c, double* rf, double* rb)
+		{
+			for (unsigned int k = 0; k < species_.size(); k++)
+				c_[species_[k]] = c[k];
+			kinetics_.ReactionRates(T, P, &c_[0], reactions_, rf, rb);
+		}
+
+		void Enthalpies(const double T, double* h)
+		{
+			kinetics_.Enthalpies(T, &h_[0]);
+
+			double inactive = 0.;
+			for (unsigned int i = 0; i < mw_.size(); i++)
+				inactive += background_[i] * h_[i];
+			double active = 0.;
+			for (unsigned int k = 0; k < species_.size(); k++)
+			{
+				inactive -= background_[species_[k]] * h_[species_[k]];
+				active += background_[species_[k]];
+			}
+			const double shift = (active > 0.) ? inactive / active : 0.;
+
+			for (unsigned int k = 0; k < species_.size(); k++)
+				h[k] = h_[species_[k]] + shift;
+		}
+
+		double Cp(const double T, const double P, const double* omega)
+		{
+			Scatter(omega);
+			return kinetics_.Cp(T, P, &omega_[0]);
+		}
+
+	private:
+
+		void Scatter(const double* omega)
+		{
+			for (unsigned int k = 0; k < species_.size(); k++)
+				omega_[species_[k]] = omega[k];
+		}
+
+	private:
+
+		MechanismKinetics& kinetics_;
+		const std::vector<double>& mw_;
+		const std::vector<unsigned int>& species_;
+		const std::vector<unsigned int>& reactions_;
+
+		std::vector<double> omega_;
+		std::vector<double> background_;
+		std::vector<double> c_;
+		std::vector<double> h_;
+	};
+
+	//!  PSR solver with the mechanism reduced on the fly for each reactor (dynamic adaptive chemistry)
+	/*!
+		 Before the solution of a reactor the DRG/DRGEP reduction is done at its current state
+		 (targets: the species above a minimum mass fraction in the inlet or in the reactor), and
+		 the reactor is solved with the SparsePSRSolver on the reduced species and reactions.
+		 The reduction is repeated at the solution: if it needs species outside the reduced
+		 mechanism, the mechanism is expanded with them and the reactor is solved again; after
+		 the maximum number of expansions (or if a reduced mechanism fails) the reactor is solved
+		 with the full mechanism. The reduced mechanism of each reactor is kept and reused until
+		 its state moves by more than the maximum distance (StateDistance), and all the reduced
+		 mechanisms are kept in a library shared by the reactors needing the same species (each
+		 with its own sparsity pattern and symbolic factorization); when the library is full the
+		 full mechanism is used.
+		 One object per thread: the library and the per-unit reductions are not synchronized.
+	*/
+	template<typename MechanismKinetics>
+	class AdaptiveChemistry
+	{
+	public:
+
+		AdaptiveChemistry(	MechanismKinetics& kinetics, const MechanismStoichiometry& stoich, const AdaptiveChemistryType type,
+							const double threshold, const unsigned int number_of_units) :
+			kinetics_(kinetics),
+			stoich_(stoich),
+			graph_(stoich),
+			type_(type),
+			threshold_(threshold),
+			ns_(stoich.NumberOfSpecies()),
+			target_fraction_(1.e-3),
+			max_distance_(0.02),
+			max_models_(64),
+			max_expansions_(4),
+			max_iterations_(500),
+			absolute_tolerance_(1.e-12),
+			relative_tolerance_(1.e-7),
+			reductions_(0),
+			expansions_(0),
+			solutions_(0),
+			active_species_(0)
+		{
+			units_.resize(number_of_units);
+			c_.resize(ns_);
+			rf_.resize(stoich.NumberOfReactions());
+			rb_.resize(stoich.NumberOfReactions());
+			omega_in_.resize(ns_);
+			y_.resize(ns_ + 1);
+		}
+
+		void SetTargetFraction(const double fraction) { target_fraction_ = fraction; }
+		void SetMaxDistance(const double distance) { max_distance_ = distance; }
+		void SetMaxModels(const unsigned int n) { max_models_ = n; }
+		void SetMaxIterations(const unsigned int n) { max_iterations_ = n; }
+		void SetTolerances(const double absolute, const double relative) { absolute_tolerance_ = absolute; relative_tolerance_ = relative; }
+		void SetReusePolicy(const JacobianReusePolicy& policy) { policy_ = policy; }
+
+		//! Statistics
+		unsigned long NumberOfReductions() const { return reductions_; }
+		unsigned long NumberOfExpansions() const { return expansions_; }
+		unsigned int NumberOfReducedMechanisms() const { return static_cast<unsigned int>(models_.size()); }
+		double MeanActiveSpecies() const { return (solutions_ > 0) ? static_cast<double>(active_species_) / solutions_ : 0.; }
+
+		//! Solves reactor unit (arguments as in SparsePSRSolver::Solve)
+		bool Solve(	const double* omega_in, const double T_in, const double P, const double mass_flow,
+					const double volume, const double tau, const double T_set, double* y, const unsigned int unit)
+		{
+			UnitReduction& reduction = units_[unit];
+
+			int model = -1;
+			if (reduction.model >= 0 && StateDistance(y, &reduction.state[0], ns_) <= max_distance_)
+				model = reduction.model;
+			else
+			{
+				Reduce(omega_in, y, P, active_);
+				model = FindOrCreate(active_);
+			}
+
+			bool converged = false;
+			for (unsigned int k = 0; ; k++)
+			{
+				ReducedModel& m = *models_[model];
+
+				// Reduced unknowns, with the initial guess of the inactive species from the inlet
+				const unsigned int n = static_cast<unsigned int>(m.species.size());
+				for (unsigned int a = 0; a < n; a++)
+				{
+					omega_in_[a] = omega_in[m.species[a]];
+					y_[a] = y[m.species[a]];
+				}
+				y_[n] = y[ns_];
+
+				m.kinetics->SetBackground(omega_in);
+				converged = m.solver->Solve(&omega_in_[0], T_in, P, mass_flow, volume, tau, T_set, &y_[0]);
+
+				std::copy(omega_in, omega_in + ns_, y);
+				for (unsigned int a = 0; a < n; a++)
+					y[m.species[a]] = y_[a];
+				y[ns_] = y_[n];
+
+				solutions_++;
+				active_species_ += n;
+
+				if (m.species.size() == ns_)
+					break;
+
+				// Expansion if the state reached needs species outside the reduced mechanism
+				if (converged == true)
+				{
+					Reduce(omega_in, y, P, active_);
+					bool closed = true;
+					for (unsigned int a = 0; a < n; a++)
+						active_[m.species[a]] = true;
+					for (unsigned int i = 0; i < ns_ && closed == true; i++)
+						if (active_[i] == true && m.active[i] == false)
+							closed = false;
+					if (closed == true)
+						break;
+				}
+
+				// Failure with the reduced mechanism or expansions exhausted: the full one is solved
+				expansions_++;
+				if (converged == false || k >= max_expansions_)
+					model = FindOrCreate(std::vector<bool>(ns_, true));
+				else
+					model = FindOrCreate(active_);
+			}
+
+			reduction.model = model;
+			reduction.state.assign(y, y + ns_ + 1);
+			return converged;
+		}
+
+	private:
+
+		//! Reduction at state y (targets: species above the minimum mass fraction in the inlet or in y)
+		void Reduce(const double* omega_in, const double* y, const double P, std::vector<bool>& active)
+		{
+			targets_.clear();
+			for (unsigned int i = 0; i < ns_; i++)
+				if (std::max(omega_in[i], y[i]) > target_fraction_)
+					targets_.push_back(i);
+			if (targets_.empty() == true)
+				targets_.push_back(static_cast<unsigned int>(std::max_element(omega_in, omega_in + ns_) - omega_in));
+
+			const double T = y[ns_];
+			const double rho = kinetics_.Density(T, P, y);
+			for (unsigned int i = 0; i < ns_; i++)
+				c_[i] = rho * y[i] / stoich_.molecular_weights[i];
+			kinetics_.ReactionRates(T, P, &c_[0], &rf_[0], &rb_[0]);
+
+			graph_.Reduce(type_, &rf_[0], &rb_[0], targets_, threshold_, active);
+			reductions_++;
+		}
+
+		//! Index of the reduced mechanism of the given species (the full one if the library is full)
+		int FindOrCreate(const std::vector<bool>& active)
+		{
+			std::map<std::vector<bool>, int>::const_iterator it = library_.find(active);
+			if (it != library_.end())
+				return it->second;
+
+			// The last place of the library is for the full mechanism
+			const std::vector<bool> full(ns_, true);
+			if (models_.size() + 1 >= max_models_ && active != full)
+				return FindOrCreate(full);
+
+			std::unique_ptr<ReducedModel> m(new ReducedModel());
+			m->active = active;
+			for (unsigned int i = 0; i < ns_; i++)
+				if (active[i] == true)
+					m->species.push_back(i);
+
+			// Reactions among the active species only
+			std::vector<int> reduced_index(ns_, -1);
+			for (unsigned int a = 0; a < m->species.size(); a++)
+			{
+				reduced_index[m->species[a]] = static_cast<int>(a);
+				m->stoich.molecular_weights.push_back(stoich_.molecular_weights[m->species[a]]);
+			}
+			const std::vector<unsigned int>& ptr = graph_.ReactionPtr();
+			const std::vector<unsigned int>& species = graph_.ReactionSpecies();
+			for (unsigned int j = 0; j < graph_.NumberOfReactions(); j++)
+			{
+				bool included = true;
+				for (unsigned int a = ptr[j]; a < ptr[j + 1] && included == true; a++)
+					included = active[species[a]];
+				if (included == false)
+					continue;
+
+				std::vector<unsigned int> reactants, products;
+				std::vector<double> nu_reactants(stoich_.reactant_coefficients.begin() + stoich_.reactant_ptr[j], stoich_.reactant_coefficients.begin() + stoich_.reactant_ptr[j + 1]);
+				std::vector<double> nu_products(stoich_.product_coefficients.begin() + stoich_.product_ptr[j], stoich_.product_coefficients.begin() + stoich_.product_ptr[j + 1]);
+				for (unsigned int a = stoich_.reactant_ptr[j]; a < stoich_.reactant_ptr[j + 1]; a++)
+					reactants.push_back(static_cast<unsigned int>(reduced_index[stoich_.reactant_species[a]]));
+				for (unsigned int a = stoich_.product_ptr[j]; a < stoich_.product_ptr[j + 1]; a++)
+					products.push_back(static_cast<unsigned int>(reduced_index[stoich_.product_species[a]]));
+				m->stoich.AddReaction(reactants, nu_reactants, products, nu_products);
+				m->reactions.push_back(j);
+			}
+
+			m->pattern.reset(new SparseJacobianPattern(m->stoich));
+			m->kinetics.reset(new ReducedKinetics<MechanismKinetics>(kinetics_, stoich_.molecular_weights, m->species, m->reactions));
+			m->solver.reset(new SparsePSRSolver< ReducedKinetics<MechanismKinetics> >(*m->kinetics, *m->pattern));
+			m->solver->SetMaxIterations(max_iterations_);
+			m->solver->SetTolerances(absolute_tolerance_, relative_tolerance_);
+			m->solver->SetReusePolicy(policy_);
+
+			const int index = static_cast<int>(models_.size());
+			models_.push_back(std::move(m));
+			library_[active] = index;
+			return index;
+		}
+
+	private:
+
+		struct ReducedModel
+		{
+			std::vector<bool> active;
+			std::vector<unsigned int> species;
+			std::vector<unsigned int> reactions;
+			MechanismStoichiometry stoich;
+			std::unique_ptr<SparseJacobianPattern> pattern;
+			std::unique_ptr< ReducedKinetics<MechanismKinetics> > kinetics;
+			std::unique_ptr< SparsePSRSolver< ReducedKinetics<MechanismKinetics> > > solver;
+		};
+
+		struct UnitReduction
+		{
+			UnitReduction() : model(-1) {}
+
+			int model;
+			std::vector<double> state;
+		};
+
+		MechanismKinetics& kinetics_;
+		const MechanismStoichiometry& stoich_;
+		DirectedRelationGraph graph_;
+		AdaptiveChemistryType type_;
+		double threshold_;
+		unsigned int ns_;
+
+		double target_fraction_;
+		double max_distance_;
+		unsigned int max_models_;
+		unsigned int max_expansions_;
+		unsigned int max_iterations_;
+		double absolute_tolerance_;
+		double relative_tolerance_;
+		JacobianReusePolicy policy_;
+
+		std::map<std::vector<bool>, int> library_;
+		std::vector< std::unique_ptr<ReducedModel> > models_;
+		std::vector<UnitReduction> units_;
+
+		unsigned long reductions_;
+		unsigned long expansions_;
+		unsigned long solutions_;
+		unsigned long active_species_;
+
+		std::vector<bool> active_;
+		std::vector<unsigned int> targets_;
+		std::vector<double> c_;
+		std::vector<double> rf_;
+		std::vector<double> rb_;
+		std::vector<double> omega_in_;
+		std::vector<double> y_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_ADAPTIVECHEMISTRY_H */
@@ -0,0 +1,567 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_BATCHEDPSRSOLVER_H
+#define NETSMOKE_BATCHEDPSRSOLVER_H
+
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include "Eigen/Dense"
+#include "NetworkTopology.h"
+#include "NetworkSolveOrder.h"
+#include "StreamStateArena.h"
+#include "NetworkTelemetry.h"
+
+namespace NetSMOKE
+{
+	//! PSRs with the same energy model, solved together
+	struct PSRBatch
+	{
+		EnergyType energy;
+		std::vector<unsigned int> units;
+	};
+
+	//! Blocks of the solve order grouped in waves, with the batches of PSRs of each wave
+	struct PSRBatchSchedule
+	{
+		// Batches of wave w: [batch_ptr[w], batch_ptr[w+1])
+		std::vector<unsigned int> batch_ptr;
+		std::vector<PSRBatch> batches;
+
+		// Blocks of wave w solved one by one (recycles, other units): [block_ptr[w], block_ptr[w+1])
+		std::vector<unsigned int> block_ptr;
+		std::vector<unsigned int> blocks;
+
+		unsigned int NumberOfWaves() const { return static_cast<unsigned int>(block_ptr.size() - 1); }
+	};
+
+	//! Groups the PSRs that are ready at the same time in batches of at most width reactors
+	/*!
+		 The wave of a block is the length of the longest path reaching it in the condensation
+		 DAG, so that all the upstream blocks of a wave are in the previous waves: once these
+		 are solved, all the blocks of the wave are ready (as in the NetworkTaskScheduler) and
+		 independent of each other. The isothermal and adiabatic PSRs forming a block alone
+		 (i.e. the feed-forward chains and branches) are batched within their wave. The units of
+		 recycle blocks depend on each other through the tear streams and are never batched:
+		 they are left to the sweeps of their block, as the other units and the PSRs with heat
+		 exchange (whose energy equation is not shared).
+	*/
+	inline void GroupReadyPSRs(const NetworkTopology& topology, const NetworkSolveOrder& order, const unsigned int width, PSRBatchSchedule& schedule)
+	{
+		const unsigned int nb = order.NumberOfBlocks();
+		const std::vector<unsigned int>& ptr = order.BlockPredecessorPtr();
+		const std::vector<unsigned int>& predecessors = order.BlockPredecessors();
+
+		// Blocks are in topological order: the waves of the predecessors are already known
+		std::vector<unsigned int> wave(nb, 0);
+		unsigned int number_of_waves = 0;
+		for (unsigned int b = 0; b < nb; b++)
+		{
+			for (unsigned int j = ptr[b]; j < ptr[b + 1]; j++)
+				wave[b] = std::max(wave[b], wave[predecessors[j]] + 1);
+			number_of_waves = std::max(number_of_waves, wave[b] + 1);
+		}
+
+		std::vector< std::vector<unsigned int> > psrs(2 * number_of_waves);
+		std::vector< std::vector<unsigned int> > others(number_of_waves);
+		for (unsigned int b = 0; b < nb; b++)
+		{
+			const unsigned int unit = order.BlockUnits()[order.BlockPtr()[b]];
+			const bool single = (order.IsRecycle(b) == false && order.BlockPtr()[b + 1] - order.BlockPtr()[b] == 1);
+			if (single == true && topology.Type()[unit] == UNIT_PSR && topology.Energy()[unit] == ENERGY_ISOTHERMAL)
+				psrs[2 * wave[b]].push_back(unit);
+			else if (single == true && topology.Type()[unit] == UNIT_PSR && topology.Energy()[unit] == ENERGY_ADIABATIC)
+				psrs[2 * wave[b] + 1].push_back(unit);
+			else
+				others[wave[b]].push_back(b);
+		}
+
+		const EnergyType energies[2] = { ENERGY_ISOTHERMAL, ENERGY_ADIABATIC };
+		schedule.batch_ptr.assign(1, 0);
+		schedule.batches.clear();
+		schedule.block_ptr.assign(1, 0);
+		schedule.blocks.clear();
+		for (unsigned int w = 0; w < number_of_waves; w++)
+		{
+			for (unsigned int e = 0; e < 2; e++)
+			{
+				const std::vector<unsigned int>& units = psrs[2 * w + e];
+				for (unsigned int k = 0; k < units.size(); k += width)
+				{
+					PSRBatch batch;
+					batch.energy = energies[e];
+					batch.units.assign(units.begin() + k, units.begin() + std::min<size_t>(k + width, units.size()));
+					schedule.batches.push_back(batch);
+				}
+			}
+			schedule.batch_ptr.push_back(static_cast<unsigned int>(schedule.batches.size()));
+
+			schedule.blocks.insert(schedule.blocks.end(), others[w].begin(), others[w].end());
+			schedule.block_ptr.push_back(static_cast<unsigned int>(schedule.blocks.size()));
+		}
+	}
+
+	//!  Steady-state solution of a batch of PSRs advanced in lock-step
+	/*!
+		 All the per-reactor quantities are stored lane-major, i.e. species i of reactor l is at
+		 [i*L+l] where L is the number of reactors still active, so that the kinetics evaluates
+		 the whole batch in a single call with the reactors in contiguous (vectorizable) lanes.
+		 The reactors are advanced together with pseudo-transient continuation (one linearized
+		 backward Euler step per iteration, time step grown by switched evolution relaxation).
+		 The Jacobian is evaluated by finite differences perturbing the same unknown in all the
+		 lanes at once (NS+1 batched evaluations). Converged reactors leave the batch and the
+		 remaining lanes are packed.
+
+		 The BatchKinetics class must provide (arrays lane-major, lanes = number of reactors):
+		 - unsigned int NumberOfSpecies() const
+		 - void Density(lanes, const double* T, const double* P, const double* omega, double* rho)
+		 - void SourceTerms(lanes, const double* T, const double* P, const double* omega, double* S, double* Q)
+		   with S_i = Omega_i/rho [1/s] and Q = -sum(h_i Omega_i)/(rho cp) [K/s]
+		 - void Enthalpies(lanes, const double* T, double* h)								[J/kg]
+		 - void Cp(lanes, const double* T, const double* P, const double* omega, double* cp)	[J/kg/K]
+
+		 The feed of each reactor is the mass-weighted mixture of its inlet streams (already
+		 solved in the StreamStateArena), with enthalpy H_in = sum_j m_j h(T_j, omega_j) / m.
+		 The adiabatic energy balance is the enthalpy balance of the feed heated to the reactor
+		 temperature, i.e. (H_in - sum_i omega_in,i h_i(T)) / (tau cp) + Q = 0.
+	*/
+	template<typename BatchKinetics>
+	class BatchedPSRSolver
+	{
+	public:
+
+		BatchedPSRSolver(BatchKinetics& kinetics) :
+			kinetics_(kinetics),
+			ns_(kinetics.NumberOfSpecies()),
+			ne_(kinetics.NumberOfSpecies() + 1),
+			max_iterations_(500),
+			absolute_tolerance_(1.e-12),
+			relative_tolerance_(1.e-7),
+			telemetry_(nullptr)
+		{
+		}
+
+		void SetMaxIterations(const unsigned int n) { max_iterations_ = n; }
+		void SetTolerances(const double absolute, const double relative) { absolute_tolerance_ = absolute; relative_tolerance_ = relative; }
+
+		//! Telemetry receiving the statistics of every reactor (null: none); the wall time of a batch is shared equally by its reactors
+		void SetTelemetry(NetworkTelemetry* telemetry) { telemetry_ = telemetry; }
+
+		//! Solves the reactors of the batch and writes their outlet streams, returns true if all of them converged
+		bool Solve(const PSRBatch& batch, const NetworkTopology& topology, StreamStateArena& arena)
+		{
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			Gather(batch, topology, arena);
+
+			std::vector<unsigned int> keep;
+			for (unsigned int k = 0; k < max_iterations_ && lanes_ > 0; k++)
+			{
+				Jacobian();
+				Step();
+
+				// Every lane still active had its own Jacobian and factorization
+				if (telemetry_ != nullptr)
+					for (unsigned int l = 0; l < lanes_; l++)
+					{
+						UnitCounters& counters = telemetry_->Local(unit_[l]);
+						counters.newton_iterations++;
+						counters.jacobian_evaluations++;
+						counters.factorizations++;
+					}
+
+				keep.clear();
+				for (unsigned int l = 0; l < lanes_; l++)
+				{
+					if (Converged(l) == true)
+						Scatter(l, topology, arena);
+					else
+						keep.push_back(l);
+				}
+				if (keep.size() != lanes_)
+					Pack(keep);
+			}
+
+			for (unsigned int l = 0; l < lanes_; l++)
+			{
+				std::cout << "PSR " << topology.UnitNames()[unit_[l]] << " did not converge in the batched solver" << std::endl;
+				Scatter(l, topology, arena);
+				if (telemetry_ != nullptr)
+					telemetry_->Local(unit_[l]).failures++;
+			}
+
+			if (telemetry_ != nullptr)
+			{
+				const double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / batch.units.size();
+				for (unsigned int l = 0; l < batch.units.size(); l++)
+				{
+					UnitCounters& counters = telemetry_->Local(batch.units[l]);
+					counters.wall_time += wall_time;
+					counters.calls++;
+				}
+			}
+
+			return (lanes_ == 0);
+		}
+
+	private:
+
+		void Gather(const PSRBatch& batch, const NetworkTopology& topology, const StreamStateArena& arena)
+		{
+			const unsigned int L = static_cast<unsigned int>(batch.units.size());
+			lanes_ = L;
+			isothermal_ = (batch.energy == ENERGY_ISOTHERMAL);
+
+			unit_ = batch.units;
+			y_.assign(ne_ * L, 0.);
+			omega_in_.assign(ns_ * L, 0.);
+			T_in_.assign(L, 0.);
+			H_in_.assign(L, 0.);
+			h_inlet_.resize(ns_);
+			T_set_.assign(L, 0.);
+			P_.assign(L, 0.);
+			mass_flow_.assign(L, 0.);
+			volume_.assign(L, 0.);
+			tau_.assign(L, 0.);
+			dt_.assign(L, 0.);
+			norm_.assign(L, 0.);
+
+			for (unsigned int l = 0; l < L; l++)
+			{
+				const unsigned int unit = unit_[l];
+				double m = 0.;
+				double T = 0.;
+				double H = 0.;
+				double P = 0.;
+				for (unsigned int j = topology.InletPtr()[unit]; j < topology.InletPtr()[unit + 1]; j++)
+				{
+					const unsigned int s = topology.InletStreams()[j];
+					const double mj = arena.MassFlow(s);
+					const double* omega = arena.MassFractions(s);
+					const double Tj = arena.Temperature(s);
+					for (unsigned int i = 0; i < ns_; i++)
+						omega_in_[i * L + l] += mj * omega[i];
+					if (isothermal_ == false)
+					{
+						kinetics_.Enthalpies(1, &Tj, &h_inlet_[0]);
+						for (unsigned int i = 0; i < ns_; i++)
+							H += mj * omega[i] * h_inlet_[i];
+					}
+					m += mj;
+					T += mj * Tj;
+					P = (P == 0.) ? arena.Pressure(s) : std::min(P, arena.Pressure(s));
+				}
+				if (m <= 0.)
+					OpenSMOKE::FatalErrorMessage("PSR " + topology.UnitNames()[unit] + ": the total inlet mass flow rate is not positive");
+
+				for (unsigned int i = 0; i < ns_; i++)
+					omega_in_[i * L + l] /= m;
+				T_in_[l] = T / m;
+				H_in_[l] = H / m;
+				P_[l] = (topology.Pressure()[unit] > 0.) ? topology.Pressure()[unit] : P;
+				mass_flow_[l] = m;
+				volume_[l] = topology.Volume()[unit];
+				tau_[l] = topology.ResidenceTime()[unit];
+
+				// Warm start from the outlet of the previous sweep, if available
+				const unsigned int outlet = topology.OutletStreams()[topology.OutletPtr()[unit]];
+				const bool warm = (arena.Temperature(outlet) > 0.);
+				const double* omega = warm ? arena.MassFractions(outlet) : &omega_in_[0];
+				for (unsigned int i = 0; i < ns_; i++)
+					y_[i * L + l] = warm ? omega[i] : omega_in_[i * L + l];
+
+				if (isothermal_ == true)
+					y_[ns_ * L + l] = topology.Temperature()[unit];
+				else
+					y_[ns_ * L + l] = warm ? arena.Temperature(outlet) : T_in_[l];
+				T_set_[l] = topology.Temperature()[unit];
+			}
+
+			// The initial time step is a fraction of the residence time
+			f_.resize(ne_ * L);
+			Residuals(y_, f_);
+			for (unsigned int l = 0; l < L; l++)
+			{
+				dt_[l] = 1.e-3 * tau_l_[l];
+				norm_[l] = 0.;
+			}
+		}
+
+		//! Outlet streams of lane l; the mass flow rate is split in proportion to the rates given in input
+		/*!
+			 If all the outlets have a rate in input (FlowsFile) the total flow rate of the reactor is
+			 split in proportion to them; otherwise the outlets with a rate keep it and the others
+			 share the remainder equally.
+		*/
+		void Scatter(const unsigned int l, const NetworkTopology& topology, StreamStateArena& arena) const
+		{
+			const unsigned int L = lanes_;
+			const unsigned int unit = unit_[l];
+			const unsigned int first = topology.OutletPtr()[unit];
+			const unsigned int last = topology.OutletPtr()[unit + 1];
+
+			double given = 0.;
+			unsigned int unknown = 0;
+			for (unsigned int j = first; j < last; j++)
+			{
+				const double m = topology.StreamMassFlow()[topology.OutletStreams()[j]];
+				if (m >= 0.)
+					given += m;
+				else
+					unknown++;
+			}
+
+			for (unsigned int j = first; j < last; j++)
+			{
+				const unsigned int s = topology.OutletStreams()[j];
+				double* omega = arena.MassFractions(s);
+				for (unsigned int i = 0; i < ns_; i++)
+					omega[i] = y_[i * L + l];
+				arena.Temperature(s) = y_[ns_ * L + l];
+				arena.Pressure(s) = P_[l];
+
+				const double m = topology.StreamMassFlow()[s];
+				if (unknown == 0 && given > 0.)
+					arena.MassFlow(s) = mass_flow_[l] * m / given;
+				else if (m >= 0.)
+					arena.MassFlow(s) = m;
+				else
+					arena.MassFlow(s) = std::max(0., mass_flow_[l] - given) / unknown;
+			}
+		}
+
+		//! Residence times: given in input or from the reactor volume (rho V/m)
+		void UpdateResidenceTimes(const std::vector<double>& y)
+		{
+			const unsigned int L = lanes_;
+			tau_l_.resize(L);
+			rho_.resize(L);
+			kinetics_.Density(L, &y[ns_ * L], &P_[0], &y[0], &rho_[0]);
+			for (unsigned int l = 0; l < L; l++)
+				tau_l_[l] = (tau_[l] > 0.) ? tau_[l] : rho_[l] * volume_[l] / mass_flow_[l];
+		}
+
+		void Residuals(const std::vector<double>& y, std::vector<double>& f)
+		{
+			const unsigned int L = lanes_;
+			S_.resize(ns_ * L);
+			Q_.resize(L);
+
+			UpdateResidenceTimes(y);
+			kinetics_.SourceTerms(L, &y[ns_ * L], &P_[0], &y[0], &S_[0], &Q_[0]);
+
+			for (unsigned int i = 0; i < ns_; i++)
+				for (unsigned int l = 0; l < L; l++)
+					f[i * L + l] = (omega_in_[i * L + l] - y[i * L + l]) / tau_l_[l] + S_[i * L + l];
+
+			if (isothermal_ == true)
+			{
+				for (unsigned int l = 0; l < L; l++)
+					f[ns_ * L + l] = (T_set_[l] - y[ns_ * L + l]) / tau_l_[l];
+				return;
+			}
+
+			// Enthalpy of the feed at the reactor temperature
+			h_species_.resize(ns_ * L);
+			cp_.resize(L);
+			H_feed_.assign(L, 0.);
+			kinetics_.Enthalpies(L, &y[ns_ * L], &h_species_[0]);
+			kinetics_.Cp(L, &y[ns_ * L], &P_[0], &y[0], &cp_[0]);
+			for (unsigned int i = 0; i < ns_; i++)
+				for (unsigned int l = 0; l < L; l++)
+					H_feed_[l] += omega_in_[i * L + l] * h_species_[i * L + l];
+
+			for (unsigned int l = 0; l < L; l++)
+				f[ns_ * L + l] = (H_in_[l] - H_feed_[l]) / (tau_l_[l] * cp_[l]) + Q_[l];
+		}
+
+		//! Finite-difference Jacobian: column j of all the reactors with one batched evaluation
+		void Jacobian()
+		{
+			const unsigned int L = lanes_;
+			const double eta = 1.e-7;
+
+			jacobian_.resize(static_cast<size_t>(ne_) * ne_ * L);
+			y_perturbed_ = y_;
+			f_perturbed_.resize(ne_ * L);
+			h_.resize(L);
+
+			for (unsigned int j = 0; j < ne_; j++)
+			{
+				const double floor = (j == ns_) ? 1. : 1.e-10;
+				for (unsigned int l = 0; l < L; l++)
+				{
+					h_[l] = eta * std::max(std::fabs(y_[j * L + l]), floor);
+					y_perturbed_[j * L + l] = y_[j * L + l] + h_[l];
+				}
+
+				Residuals(y_perturbed_, f_perturbed_);
+
+				for (unsigned int l = 0; l < L; l++)
+				{
+					double* column = &jacobian_[(static_cast<size_t>(l) * ne_ + j) * ne_];
+					for (unsigned int i = 0; i < ne_; i++)
+						column[i] = (f_perturbed_[i * L + l] - f_[i * L + l]) / h_[l];
+					y_perturbed_[j * L + l] = y_[j * L + l];
+				}
+			}
+
+			// Restores residence times and source terms of the unperturbed state
+			UpdateResidenceTimes(y_);
+		}
+
+		//! Linearized backward Euler step (I/dt - J) dy = f for every reactor
+		void Step()
+		{
+			const unsigned int L = lanes_;
+			Eigen::MatrixXd A(ne_, ne_);
+			Eigen::VectorXd b(ne_);
+			Eigen::PartialPivLU<Eigen::MatrixXd> lu;
+
+			for (unsigned int l = 0; l < L; l++)
+			{
+				A = -Eigen::Map<const Eigen::MatrixXd>(&jacobian_[static_cast<size_t>(l) * ne_ * ne_], ne_, ne_);
+				A.diagonal().array() += 1. / dt_[l];
+				for (unsigned int i = 0; i < ne_; i++)
+					b(i) = f_[i * L + l];
+
+				lu.compute(A);
+				b = lu.solve(b);
+
+				for (unsigned int i = 0; i < ns_; i++)
+					y_[i * L + l] = std::max(0., y_[i * L + l] + b(i));
+				y_[ns_ * L + l] += b(ns_);
+
+				// Switched evolution relaxation on the scaled residual norm
+				double norm = 0.;
+				for (unsigned int i = 0; i < ne_; i++)
+					norm = std::max(norm, std::fabs(f_[i * L + l] / Scale(i, l)));
+				if (norm_[l] > 0.)
+					dt_[l] *= std::min(10., std::max(0.1, norm_[l] / norm));
+				dt_[l] = std::min(dt_[l], 1.e10 * tau_l_[l]);
+				norm_[l] = norm;
+			}
+
+			Residuals(y_, f_);
+		}
+
+		double Scale(const unsigned int i, const unsigned int l) const
+		{
+			return absolute_tolerance_ + relative_tolerance_ * std::fabs(y_[i * lanes_ + l]);
+		}
+
+		//! Change of the unknowns over one residence time below the tolerances (never for a non-finite or non-positive temperature)
+		bool Converged(const unsigned int l) const
+		{
+			if (!(y_[ns_ * lanes_ + l] > 0.))
+				return false;
+			for (unsigned int i = 0; i < ne_; i++)
+				if (!(std::fabs(f_[i * lanes_ + l]) * tau_l_[l] <= Scale(i, l)))
+					return false;
+			return true;
+		}
+
+		//! Keeps only the given lanes (in the given order)
+		void Pack(const std::vector<unsigned int>& keep)
+		{
+			const unsigned int L = lanes_;
+			const unsigned int K = static_cast<unsigned int>(keep.size());
+
+			PackRows(y_, ne_, L, keep);
+			PackRows(f_, ne_, L, keep);
+			PackRows(omega_in_, ns_, L, keep);
+			PackRows(T_in_, 1, L, keep);
+			PackRows(H_in_, 1, L, keep);
+			PackRows(T_set_, 1, L, keep);
+			PackRows(P_, 1, L, keep);
+			PackRows(mass_flow_, 1, L, keep);
+			PackRows(volume_, 1, L, keep);
+			PackRows(tau_, 1, L, keep);
+			PackRows(tau_l_, 1, L, keep);
+			PackRows(dt_, 1, L, keep);
+			PackRows(norm_, 1, L, keep);
+
+			std::vector<unsigned int> unit(K);
+			for (unsigned int k = 0; k < K; k++)
+				unit[k] = unit_[keep[k]];
+			unit_.swap(unit);
+
+			lanes_ = K;
+		}
+
+		static void PackRows(std::vector<double>& v, const unsigned int rows, const unsigned int L, const std::vector<unsigned int>& keep)
+		{
+			const unsigned int K = static_cast<unsigned int>(keep.size());
+			for (unsigned int r = 0; r < rows; r++)
+				for (unsigned int k = 0; k < K; k++)
+					v[r * K + k] = v[r * L + keep[k]];
+			v.resize(rows * K);
+		}
+
+	private:
+
+		BatchKinetics& kinetics_;
+		unsigned int ns_;
+		unsigned int ne_;
+
+		unsigned int max_iterations_;
+		double absolute_tolerance_;
+		double relative_tolerance_;
+		NetworkTelemetry* telemetry_;
+
+		bool isothermal_;
+		unsigned int lanes_;
+		std::vector<unsigned int> unit_;
+
+		// Lane-major unknowns (species and temperature) and residuals
+		std::vector<double> y_;
+		std::vector<double> f_;
+
+		// Feed and reactor data
+		std::vector<double> omega_in_;
+		std::vector<double> T_in_;
+		std::vector<double> H_in_;
+		std::vector<double> T_set_;
+		std::vector<double> P_;
+		std::vector<double> mass_flow_;
+		std::vector<double> volume_;
+		std::vector<double> tau_;
+
+		// Pseudo-transient continuation
+		std::vector<double> tau_l_;
+		std::vector<double> dt_;
+		std::vector<double> norm_;
+
+		// Work arrays
+		std::vector<double> rho_;
+		std::vector<double> S_;
+		std::vector<double> Q_;
+		std::vector<double> h_species_;
+		std::vector<double> h_inlet_;
+		std::vector<double> cp_;
+		std::vector<double> H_feed_;
+		std::vector<double> h_;
+		std::vector<double> y_perturbed_;
+		std::vector<double> f_perturbed_;
+		std::vector<double> jacobian_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_BATCHEDPSRSOLVER_H */
@@ -62,6 +62,11 @@ namespace NetSMOKE
 																"none",
 																"none") );			
 
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@ReactorBlocks", 
+																OpenSMOKE::SINGLE_DICTIONARY, 
+																"Name of the dictionary containing the list of bulk reactor blocks (i.e. from CFD clustering)", 
+																false) );
+
 			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@Mixers", 
 																OpenSMOKE::SINGLE_DICTIONARY, 
 																"Name of the dictionary containing the list of mixers in the network", 
@@ -77,6 +82,21 @@ namespace NetSMOKE
 																"Name of the dictionary containing the list of phase splitters in the network", 
 																false) );										
 
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@NetworkCache", 
+																OpenSMOKE::SINGLE_PATH, 
+																"Binary file where the compiled network is cached (reused when the input file is unchanged)", 
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@CheckpointFile", 
+																OpenSMOKE::SINGLE_PATH, 
+																"Binary file where the state of the network is periodically written (see @CheckpointInterval in @Options)", 
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@RestartFile", 
+																OpenSMOKE::SINGLE_PATH, 
+																"Checkpoint file used as initial guess (units are matched by name)", 
+																false) );
+
 			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@Options", 
 																OpenSMOKE::SINGLE_DICTIONARY, 
 																"Dictionary containing additional options for solving the reactor network", 
@@ -22,6 +22,9 @@
 #include "boost/filesystem.hpp"
 #include "dictionary/OpenSMOKE_Dictionary.h"
 #include "dictionary/OpenSMOKE_DictionaryGrammar.h"
+#include "MeasureUnits.h"
+#include "SpeciesIndexMap.h"
+#include "StreamComposition.h"
 
 namespace NetSMOKE
 {
@@ -93,7 +96,7 @@ namespace NetSMOKE
 	};
 
 	template<typename Thermodynamics>
-	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML,
+	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML, const NetSMOKE::SpeciesIndexMap& species_index,
 									double& T, double& P_Pa, OpenSMOKE::OpenSMOKEVectorDouble& omega)
 	{
 		Grammar_GasStatus grammar_gas_status;
@@ -108,13 +111,7 @@ namespace NetSMOKE
 		{
 			if (dictionary.CheckOption("@Temperature") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Temperature", value, units);
-		
-				if (units == "K")			T = value;
-				else if (units == "C")		T = value + 273.15;
-				else OpenSMOKE::FatalErrorMessage("Unknown temperature units");
+				T = ReadQuantity<DIMENSION_TEMPERATURE>(dictionary, "@Temperature").value;
 
 				state_variables++;
 				temperature_assigned = true;
@@ -125,14 +122,7 @@ namespace NetSMOKE
 		{
 			if (dictionary.CheckOption("@Pressure") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Pressure", value, units);
-
-				if (units == "Pa")			P_Pa = value;
-				else if (units == "bar")	P_Pa = value*1.e5;
-				else if (units == "atm")	P_Pa = value*101325.;
-				else OpenSMOKE::FatalErrorMessage("Unknown pressure units");
+				P_Pa = ReadQuantity<DIMENSION_PRESSURE>(dictionary, "@Pressure").value;
 
 				state_variables++;
 				pressure_assigned = true;
@@ -144,13 +134,7 @@ namespace NetSMOKE
 		{
 			if (dictionary.CheckOption("@Density") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Density", value, units);
-
-				if (units == "kg/m3")		rho = value;
-				else if (units == "g/cm3")	rho = value*1.e3;
-				else OpenSMOKE::FatalErrorMessage("Unknown density units");
+				rho = ReadQuantity<DIMENSION_DENSITY>(dictionary, "@Density").value;
 
 				state_variables++;
 				density_assigned = true;
@@ -165,10 +149,12 @@ namespace NetSMOKE
 			{
 				std::vector<std::string> names;
 				std::vector<double> values;
+				std::vector<unsigned int> indices;
 		
 				if (dictionary.CheckOption("@MoleFractions") == true)
 				{
 					dictionary.ReadOption("@MoleFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 				
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					if (sum<(1.-1e-6) || sum>(1.+1e-6))
@@ -176,7 +162,7 @@ namespace NetSMOKE
 
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for(unsigned int i=0;i<names.size();i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						x[indices[i]] = values[i]/sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega.GetHandle(),MW,x.GetHandle());
@@ -184,6 +170,7 @@ namespace NetSMOKE
 				else if (dictionary.CheckOption("@MassFractions") == true)
 				{
 					dictionary.ReadOption("@MassFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					if (sum<(1.-1e-6) || sum>(1.+1e-6))
@@ -191,15 +178,16 @@ namespace NetSMOKE
 
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					for(unsigned int i=0;i<names.size();i++)
-						omega[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						omega[indices[i]] = values[i]/sum;
 				}
 				else if (dictionary.CheckOption("@Moles") == true)
 				{
 					dictionary.ReadOption("@Moles", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for(unsigned int i=0;i<names.size();i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						x[indices[i]] = values[i]/sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega.GetHandle(),MW,x.GetHandle());
@@ -207,10 +195,11 @@ namespace NetSMOKE
 				else if (dictionary.CheckOption("@Masses") == true)
 				{
 					dictionary.ReadOption("@Masses", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					for(unsigned int i=0;i<names.size();i++)
-						omega[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						omega[indices[i]] = values[i]/sum;
 				}
 			}
 		}
@@ -224,7 +213,7 @@ namespace NetSMOKE
 	}
 
 	template<typename Thermodynamics>
-	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML,
+	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML, const NetSMOKE::SpeciesIndexMap& species_index,
 		std::vector<double>& T, std::vector<double>& P_Pa, std::vector<OpenSMOKE::OpenSMOKEVectorDouble>& omega, std::vector<double>& equivalence_ratios)
 	{
 		Grammar_GasStatus grammar_gas_status;
@@ -240,13 +229,7 @@ namespace NetSMOKE
 			T.resize(1);
 			if (dictionary.CheckOption("@Temperature") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Temperature", value, units);
-
-				if (units == "K")			T[0] = value;
-				else if (units == "C")		T[0] = value + 273.15;
-				else OpenSMOKE::FatalErrorMessage("Unknown temperature units");
+				T[0] = ReadQuantity<DIMENSION_TEMPERATURE>(dictionary, "@Temperature").value;
 
 				state_variables++;
 				temperature_assigned = true;
@@ -258,14 +241,7 @@ namespace NetSMOKE
 			P_Pa.resize(1);
 			if (dictionary.CheckOption("@Pressure") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Pressure", value, units);
-
-				if (units == "Pa")			P_Pa[0] = value;
-				else if (units == "bar")	P_Pa[0] = value*1.e5;
-				else if (units == "atm")	P_Pa[0] = value*101325.;
-				else OpenSMOKE::FatalErrorMessage("Unknown pressure units");
+				P_Pa[0] = ReadQuantity<DIMENSION_PRESSURE>(dictionary, "@Pressure").value;
 
 				state_variables++;
 				pressure_assigned = true;
@@ -277,13 +253,7 @@ namespace NetSMOKE
 		{
 			if (dictionary.CheckOption("@Density") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Density", value, units);
-
-				if (units == "kg/m3")		rho = value;
-				else if (units == "g/cm3")	rho = value*1.e3;
-				else OpenSMOKE::FatalErrorMessage("Unknown density units");
+				rho = ReadQuantity<DIMENSION_DENSITY>(dictionary, "@Density").value;
 
 				state_variables++;
 				density_assigned = true;
@@ -298,12 +268,14 @@ namespace NetSMOKE
 			{
 				std::vector<std::string> names;
 				std::vector<double> values;
+				std::vector<unsigned int> indices;
 
 				if (dictionary.CheckOption("@MoleFractions") == true)
 				{
 					omega.resize(1);
 
 					dictionary.ReadOption("@MoleFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					if (sum<(1. - 1e-6) || sum>(1. + 1e-6))
@@ -311,7 +283,7 @@ namespace NetSMOKE
 
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for (unsigned int i = 0; i<names.size(); i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						x[indices[i]] = values[i] / sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega[0].GetHandle(), MW, x.GetHandle());
@@ -321,6 +293,7 @@ namespace NetSMOKE
 					omega.resize(1);
 
 					dictionary.ReadOption("@MassFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					if (sum<(1. - 1e-6) || sum>(1. + 1e-6))
@@ -328,17 +301,18 @@ namespace NetSMOKE
 
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					for (unsigned int i = 0; i<names.size(); i++)
-						omega[0][thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						omega[0][indices[i]] = values[i] / sum;
 				}
 				else if (dictionary.CheckOption("@Moles") == true)
 				{
 					omega.resize(1);
 
 					dictionary.ReadOption("@Moles", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for (unsigned int i = 0; i<names.size(); i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						x[indices[i]] = values[i] / sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega[0].GetHandle(), MW, x.GetHandle());
@@ -347,10 +321,11 @@ namespace NetSMOKE
 				{
 					omega.resize(1);
 					dictionary.ReadOption("@Masses", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					for (unsigned int i = 0; i<names.size(); i++)
-						omega[0][thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						omega[0][indices[i]] = values[i] / sum;
 				}
 			}
 		}
@@ -380,7 +355,58 @@ namespace NetSMOKE
 			}
 		}
 	}
+
+	//! Reads the composition of an inlet in sparse form (only the species listed in the dictionary are stored)
+	template<typename Thermodynamics>
+	void GetSparseCompositionFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML, const NetSMOKE::SpeciesIndexMap& species_index,
+											NetSMOKE::StreamComposition& composition)
+	{
+		Grammar_GasStatus grammar_gas_status;
+		dictionary.SetGrammar(grammar_gas_status);
+
+		std::vector<std::string> names;
+		std::vector<double> values;
+		std::vector<unsigned int> indices;
+		bool mole_basis = false;
+
+		bool fractions = false;
+		if (dictionary.CheckOption("@MoleFractions") == true)
+		{
+			dictionary.ReadOption("@MoleFractions", names, values);
+			mole_basis = true;
+			fractions = true;
+		}
+		else if (dictionary.CheckOption("@MassFractions") == true)
+		{
+			dictionary.ReadOption("@MassFractions", names, values);
+			fractions = true;
+		}
+		else if (dictionary.CheckOption("@Moles") == true)
+		{
+			dictionary.ReadOption("@Moles", names, values);
+			mole_basis = true;
+		}
+		else if (dictionary.CheckOption("@Masses") == true)
+			dictionary.ReadOption("@Masses", names, values);
+		else
+			OpenSMOKE::FatalErrorMessage("The composition of the mixture requires one among: @MoleFractions, @MassFractions, @Moles and @Masses");
+
+		species_index.IndicesOfSpecies(names, indices);
+
+		// Species indices of the map are 1-based
+		const double sum = std::accumulate(values.begin(), values.end(), 0.);
+		if (fractions == true && (sum<(1. - 1e-6) || sum>(1. + 1e-6)))
+			OpenSMOKE::FatalErrorMessage(mole_basis == true ? "The mole fractions must sum to 1." : "The mass fractions must sum to 1.");
+		for (unsigned int i = 0; i < names.size(); i++)
+		{
+			indices[i] -= 1;
+			values[i] /= sum;
+		}
+
+		composition.SetSparse(thermodynamicsMapXML.NumberOfSpecies(), indices, values);
+		if (mole_basis == true)
+			composition.MassFractionsFromMoleFractions(thermodynamicsMapXML.MWs());
+	}
 }
 
 #endif	/* GRAMMAR_NETSMOKE_REACTORS_H */
-
@@ -0,0 +1,524 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef GRAMMAR_NETSMOKE_OPTIONS_H
+#define	GRAMMAR_NETSMOKE_OPTIONS_H
+
+#include <string>
+#include <thread>
+#include <algorithm>
+#include "dictionary/OpenSMOKE_Dictionary.h"
+#include "dictionary/OpenSMOKE_DictionaryGrammar.h"
+#include "MeasureUnits.h"
+#include "RecycleAccelerator.h"
+#include "NetworkNewtonSolver.h"
+#include "PFRCascade.h"
+#include "SparsePSRJacobian.h"
+#include "AdaptiveChemistry.h"
+
+namespace NetSMOKE
+{
+
+	class Grammar_NetSMOKE_Options : public OpenSMOKE::OpenSMOKE_DictionaryGrammar
+	{
+	protected:
+
+		virtual void DefineRules()
+		{
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@NumberOfThreads",
+																OpenSMOKE::SINGLE_INT,
+																"Number of threads used to solve independent blocks of the network (default: 1, 0 means all the available cores)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@RecycleAcceleration",
+																OpenSMOKE::SINGLE_STRING,
+																"Convergence method for the tear streams of recycle blocks: SuccessiveSubstitution | Wegstein | Anderson (default: Wegstein)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@RecycleDamping",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Damping (relaxation) factor for the recycle updates, between 0 and 1 (default: 1)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@RecycleHistory",
+																OpenSMOKE::SINGLE_INT,
+																"Number of previous iterations used by the Anderson acceleration (default: 5)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@RecycleTolerance",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Relative tolerance on the tear streams of recycle blocks (default: 1e-6)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@RecycleAbsoluteTolerance",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Absolute tolerance on the tear streams of recycle blocks, for the trace species (default: 1e-12)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@RecycleMaxIterations",
+																OpenSMOKE::SINGLE_INT,
+																"Maximum number of sweeps of a recycle block (default: 500)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@NetworkSolver",
+																OpenSMOKE::SINGLE_STRING,
+																"Solution strategy for the network: SequentialModular | GlobalNewton (default: SequentialModular)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@NewtonLinearSolver",
+																OpenSMOKE::SINGLE_STRING,
+																"Linear solver for the global Newton method: SparseLU | BiCGSTAB (block-Jacobi preconditioned) (default: SparseLU)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@NewtonMaxIterations",
+																OpenSMOKE::SINGLE_INT,
+																"Maximum number of iterations of the global Newton method (default: 50)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@NewtonAbsoluteTolerance",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Absolute tolerance of the global Newton method and of its pseudo-transient fallback (default: 1e-12)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@NewtonRelativeTolerance",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Relative tolerance of the global Newton method and of its pseudo-transient fallback (default: 1e-7)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@PSRBatchSize",
+																OpenSMOKE::SINGLE_INT,
+																"Maximum number of isothermal/adiabatic PSRs ready at the same time (outside recycles) solved together by the batched solver (default: 8, 1 means no batching)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@PSRJacobian",
+																OpenSMOKE::SINGLE_STRING,
+																"Jacobian of the PSRs: FiniteDifference (dense, batched) or SparseAnalytical (from the stoichiometry, sparse LU) (default: FiniteDifference)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@JacobianReuse",
+																OpenSMOKE::SINGLE_BOOL,
+																"Reuse of the sparse PSR Jacobians and factorizations over the Newton iterations, the recycle sweeps and similar reactors (default: false)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@JacobianReuseMaxRate",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Contraction rate of the Newton residuals above which a reused Jacobian is evaluated again (default: 0.5)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@JacobianReuseMaxAge",
+																OpenSMOKE::SINGLE_INT,
+																"Maximum number of Newton iterations with the same Jacobian (default: 20)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@JacobianReuseSimilarity",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Maximum distance of two states (mass fractions, relative temperature) sharing the same Jacobian (default: 0.02)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@JacobianCacheMaxMemory",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Maximum memory of the Jacobians kept between the recycle sweeps in MB (default: 256)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@AdaptiveChemistry",
+																OpenSMOKE::SINGLE_STRING,
+																"Mechanism reduced on the fly for each PSR solved with the SparseAnalytical Jacobian: None, DRG, DRGEP (default: None)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@AdaptiveChemistryThreshold",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Threshold of the DRG/DRGEP interaction coefficients below which species are removed (default: 1e-3)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@ISAT",
+																OpenSMOKE::SINGLE_BOOL,
+																"In situ adaptive tabulation of the PSR solutions, shared by all the reactors (default: false)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@ISATTolerance",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Error tolerance of the ISAT linear approximation (default: 1e-4)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@ISATMaxMemory",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Maximum memory of the ISAT table in MB (default: 512)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@CheckpointInterval",
+																OpenSMOKE::SINGLE_MEASURE,
+																"Minimum time between two checkpoints of the network state (default: 10 min)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@Telemetry",
+																OpenSMOKE::SINGLE_BOOL,
+																"Per-unit counters, recycle residual histories, global Newton and sweep statistics, written as Telemetry.csv and Telemetry.json in the output folder (default: false)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@TelemetryTrace",
+																OpenSMOKE::SINGLE_BOOL,
+																"Every call of every unit is also written in Chrome trace format as Telemetry.trace.json (default: false)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@PFRModel",
+																OpenSMOKE::SINGLE_STRING,
+																"Model of the PFRs: ODE, Cascade (adaptive cascade of PSRs), Auto (the cheaper one within @PFRCascadeTolerance) (default: ODE)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@PFRCascadeTolerance",
+																OpenSMOKE::SINGLE_DOUBLE,
+																"Maximum error of the outlet of the PSR cascade on mass fractions and relative temperature (default: 1e-4)",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@PFRCascadeMaxCells",
+																OpenSMOKE::SINGLE_INT,
+																"Maximum number of PSRs of the cascade of a PFR (default: 256)",
+																false) );
+		}
+	};
+
+	class NetworkOptions
+	{
+	public:
+
+		NetworkOptions() :
+			number_of_threads_(1),
+			recycle_acceleration_(RECYCLE_WEGSTEIN),
+			recycle_damping_(1.),
+			recycle_history_(5),
+			recycle_tolerance_(1.e-6),
+			recycle_absolute_tolerance_(1.e-12),
+			recycle_max_iterations_(500),
+			network_solver_(NETWORK_SOLVER_SEQUENTIAL_MODULAR),
+			newton_linear_solver_(NEWTON_LINEAR_SOLVER_SPARSELU),
+			newton_max_iterations_(50),
+			newton_absolute_tolerance_(1.e-12),
+			newton_relative_tolerance_(1.e-7),
+			psr_batch_size_(8),
+			psr_jacobian_(PSR_JACOBIAN_FINITE_DIFFERENCE),
+			jacobian_cache_max_memory_(256.),
+			adaptive_chemistry_(ADAPTIVE_CHEMISTRY_NONE),
+			adaptive_chemistry_threshold_(1.e-3),
+			isat_(false),
+			isat_tolerance_(1.e-4),
+			isat_max_memory_(512.),
+			checkpoint_interval_(600.),
+			telemetry_(false),
+			telemetry_trace_(false),
+			pfr_model_(PFR_MODEL_ODE),
+			pfr_cascade_tolerance_(1.e-4),
+			pfr_cascade_max_cells_(256)
+		{
+		}
+
+		void SetupFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary)
+		{
+			Grammar_NetSMOKE_Options grammar_options;
+			dictionary.SetGrammar(grammar_options);
+
+			if (dictionary.CheckOption("@NumberOfThreads") == true)
+			{
+				int value;
+				dictionary.ReadInt("@NumberOfThreads", value);
+
+				if (value < 0)
+					OpenSMOKE::FatalErrorMessage("@NumberOfThreads must be equal or larger than 0");
+				else if (value == 0)
+					number_of_threads_ = std::max(1u, std::thread::hardware_concurrency());
+				else
+					number_of_threads_ = static_cast<unsigned int>(value);
+			}
+
+			if (dictionary.CheckOption("@RecycleAcceleration") == true)
+			{
+				std::string value;
+				dictionary.ReadString("@RecycleAcceleration", value);
+				recycle_acceleration_ = RecycleAccelerationTypeFromString(value);
+			}
+
+			if (dictionary.CheckOption("@RecycleDamping") == true)
+			{
+				dictionary.ReadDouble("@RecycleDamping", recycle_damping_);
+				if (recycle_damping_ <= 0. || recycle_damping_ > 1.)
+					OpenSMOKE::FatalErrorMessage("@RecycleDamping must be in (0,1]");
+			}
+
+			if (dictionary.CheckOption("@RecycleHistory") == true)
+			{
+				int value;
+				dictionary.ReadInt("@RecycleHistory", value);
+				if (value < 1)
+					OpenSMOKE::FatalErrorMessage("@RecycleHistory must be at least 1");
+				recycle_history_ = static_cast<unsigned int>(value);
+			}
+
+			if (dictionary.CheckOption("@RecycleTolerance") == true)
+			{
+				dictionary.ReadDouble("@RecycleTolerance", recycle_tolerance_);
+				if (recycle_tolerance_ <= 0.)
+					OpenSMOKE::FatalErrorMessage("@RecycleTolerance must be positive");
+			}
+
+			if (dictionary.CheckOption("@RecycleAbsoluteTolerance") == true)
+			{
+				dictionary.ReadDouble("@RecycleAbsoluteTolerance", recycle_absolute_tolerance_);
+				if (recycle_absolute_tolerance_ <= 0.)
+					OpenSMOKE::FatalErrorMessage("@RecycleAbsoluteTolerance must be positive");
+			}
+
+			if (dictionary.CheckOption("@RecycleMaxIterations") == true)
+			{
+				int value;
+				dictionary.ReadInt("@RecycleMaxIterations", value);
+				if (value < 1)
+					OpenSMOKE::FatalErrorMessage("@RecycleMaxIterations must be at least 1");
+				recycle_max_iterations_ = static_cast<unsigned int>(value);
+			}
+
+			if (dictionary.CheckOption("@NetworkSolver") == true)
+			{
+				std::string value;
+				dictionary.ReadString("@NetworkSolver", value);
+				network_solver_ = NetworkSolverTypeFromString(value);
+			}
+
+			if (dictionary.CheckOption("@NewtonLinearSolver") == true)
+			{
+				std::string value;
+				dictionary.ReadString("@NewtonLinearSolver", value);
+				newton_linear_solver_ = NewtonLinearSolverTypeFromString(value);
+			}
+
+			if (dictionary.CheckOption("@NewtonMaxIterations") == true)
+			{
+				int value;
+				dictionary.ReadInt("@NewtonMaxIterations", value);
+				if (value < 1)
+					OpenSMOKE::FatalErrorMessage("@NewtonMaxIterations must be at least 1");
+				newton_max_iterations_ = static_cast<unsigned int>(value);
+			}
+
+			if (dictionary.CheckOption("@NewtonAbsoluteTolerance") == true)
+			{
+				dictionary.ReadDouble("@NewtonAbsoluteTolerance", newton_absolute_tolerance_);
+				if (newton_absolute_tolerance_ <= 0.)
+					OpenSMOKE::FatalErrorMessage("@NewtonAbsoluteTolerance must be positive");
+			}
+
+			if (dictionary.CheckOption("@NewtonRelativeTolerance") == true)
+			{
+				dictionary.ReadDouble("@NewtonRelativeTolerance", newton_relative_tolerance_);
+				if (newton_relative_tolerance_ <= 0.)
+					OpenSMOKE::FatalErrorMessage("@NewtonRelativeTolerance must be positive");
+			}
+
+			if (dictionary.CheckOption("@PSRBatchSize") == true)
+			{
+				int value;
+				dictionary.ReadInt("@PSRBatchSize", value);
+				if (value < 1)
+					OpenSMOKE::FatalErrorMessage("@PSRBatchSize must be at least 1");
+				psr_batch_size_ = static_cast<unsigned int>(value);
+			}
+
+			if (dictionary.CheckOption("@PSRJacobian") == true)
+			{
+				std::string value;
+				dictionary.ReadString("@PSRJacobian", value);
+				psr_jacobian_ = PSRJacobianTypeFromString(value);
+			}
+
+			if (dictionary.CheckOption("@JacobianReuse") == true)
+				dictionary.ReadBool("@JacobianReuse", jacobian_reuse_.enabled);
+
+			if (dictionary.CheckOption("@JacobianReuseMaxRate") == true)
+			{
+				dictionary.ReadDouble("@JacobianReuseMaxRate", jacobian_reuse_.max_convergence_rate);
+				if (jacobian_reuse_.max_convergence_rate <= 0. || jacobian_reuse_.max_convergence_rate > 1.)
+					OpenSMOKE::FatalErrorMessage("@JacobianReuseMaxRate must be in (0,1]");
+			}
+
+			if (dictionary.CheckOption("@JacobianReuseMaxAge") == true)
+			{
+				int value;
+				dictionary.ReadInt("@JacobianReuseMaxAge", value);
+				if (value < 1)
+					OpenSMOKE::FatalErrorMessage("@JacobianReuseMaxAge must be at least 1");
+				jacobian_reuse_.max_age = static_cast<unsigned int>(value);
+			}
+
+			if (dictionary.CheckOption("@JacobianReuseSimilarity") == true)
+			{
+				dictionary.ReadDouble("@JacobianReuseSimilarity", jacobian_reuse_.similarity);
+				if (jacobian_reuse_.similarity < 0.)
+					OpenSMOKE::FatalErrorMessage("@JacobianReuseSimilarity must be non-negative");
+			}
+
+			if (dictionary.CheckOption("@JacobianCacheMaxMemory") == true)
+			{
+				dictionary.ReadDouble("@JacobianCacheMaxMemory", jacobian_cache_max_memory_);
+				if (jacobian_cache_max_memory_ < 0.)
+					OpenSMOKE::FatalErrorMessage("@JacobianCacheMaxMemory must be non-negative");
+			}
+
+			if (dictionary.CheckOption("@AdaptiveChemistry") == true)
+			{
+				std::string value;
+				dictionary.ReadString("@AdaptiveChemistry", value);
+				adaptive_chemistry_ = AdaptiveChemistryFromString(value);
+				if (adaptive_chemistry_ != ADAPTIVE_CHEMISTRY_NONE && psr_jacobian_ != PSR_JACOBIAN_SPARSE_ANALYTICAL)
+					OpenSMOKE::FatalErrorMessage("@AdaptiveChemistry requires @PSRJacobian SparseAnalytical");
+			}
+
+			if (dictionary.CheckOption("@AdaptiveChemistryThreshold") == true)
+			{
+				dictionary.ReadDouble("@AdaptiveChemistryThreshold", adaptive_chemistry_threshold_);
+				if (adaptive_chemistry_threshold_ <= 0. || adaptive_chemistry_threshold_ >= 1.)
+					OpenSMOKE::FatalErrorMessage("@AdaptiveChemistryThreshold must be in (0,1)");
+			}
+
+			if (dictionary.CheckOption("@ISAT") == true)
+				dictionary.ReadBool("@ISAT", isat_);
+
+			if (dictionary.CheckOption("@ISATTolerance") == true)
+			{
+				dictionary.ReadDouble("@ISATTolerance", isat_tolerance_);
+				if (isat_tolerance_ <= 0.)
+					OpenSMOKE::FatalErrorMessage("@ISATTolerance must be positive");
+			}
+
+			if (dictionary.CheckOption("@ISATMaxMemory") == true)
+			{
+				dictionary.ReadDouble("@ISATMaxMemory", isat_max_memory_);
+				if (isat_max_memory_ <= 0.)
+					OpenSMOKE::FatalErrorMessage("@ISATMaxMemory must be positive");
+			}
+
+			if (dictionary.CheckOption("@CheckpointInterval") == true)
+			{
+				checkpoint_interval_ = ReadQuantity<DIMENSION_TIME>(dictionary, "@CheckpointInterval").value;
+			}
+
+			if (dictionary.CheckOption("@Telemetry") == true)
+				dictionary.ReadBool("@Telemetry", telemetry_);
+
+			if (dictionary.CheckOption("@TelemetryTrace") == true)
+				dictionary.ReadBool("@TelemetryTrace", telemetry_trace_);
+
+			if (dictionary.CheckOption("@PFRModel") == true)
+			{
+				std::string value;
+				dictionary.ReadString("@PFRModel", value);
+				pfr_model_ = PFRModelFromString(value);
+			}
+
+			if (dictionary.CheckOption("@PFRCascadeTolerance") == true)
+			{
+				dictionary.ReadDouble("@PFRCascadeTolerance", pfr_cascade_tolerance_);
+				if (pfr_cascade_tolerance_ <= 0.)
+					OpenSMOKE::FatalErrorMessage("@PFRCascadeTolerance must be positive");
+			}
+
+			if (dictionary.CheckOption("@PFRCascadeMaxCells") == true)
+			{
+				int value;
+				dictionary.ReadInt("@PFRCascadeMaxCells", value);
+				if (value < 4)
+					OpenSMOKE::FatalErrorMessage("@PFRCascadeMaxCells must be at least 4");
+				pfr_cascade_max_cells_ = static_cast<unsigned int>(value);
+			}
+		}
+
+		unsigned int NumberOfThreads() const { return number_of_threads_; }
+
+		RecycleAccelerationType RecycleAcceleration() const { return recycle_acceleration_; }
+		double RecycleDamping() const { return recycle_damping_; }
+		unsigned int RecycleHistory() const { return recycle_history_; }
+		double RecycleTolerance() const { return recycle_tolerance_; }
+		double RecycleAbsoluteTolerance() const { return recycle_absolute_tolerance_; }
+		unsigned int RecycleMaxIterations() const { return recycle_max_iterations_; }
+
+		NetworkSolverType NetworkSolver() const { return network_solver_; }
+		NewtonLinearSolverType NewtonLinearSolver() const { return newton_linear_solver_; }
+		unsigned int NewtonMaxIterations() const { return newton_max_iterations_; }
+		double NewtonAbsoluteTolerance() const { return newton_absolute_tolerance_; }
+		double NewtonRelativeTolerance() const { return newton_relative_tolerance_; }
+
+		unsigned int PSRBatchSize() const { return psr_batch_size_; }
+		PSRJacobianType PSRJacobian() const { return psr_jacobian_; }
+		const JacobianReusePolicy& JacobianReuse() const { return jacobian_reuse_; }
+		double JacobianCacheMaxMemory() const { return jacobian_cache_max_memory_; }
+
+		AdaptiveChemistryType AdaptiveChemistryMethod() const { return adaptive_chemistry_; }
+		double AdaptiveChemistryThreshold() const { return adaptive_chemistry_threshold_; }
+
+		bool ISAT() const { return isat_; }
+		double ISATTolerance() const { return isat_tolerance_; }
+		double ISATMaxMemory() const { return isat_max_memory_; }
+
+		//! Minimum time between two checkpoints [s]
+		double CheckpointInterval() const { return checkpoint_interval_; }
+
+		bool Telemetry() const { return telemetry_ || telemetry_trace_; }
+		bool TelemetryTrace() const { return telemetry_trace_; }
+
+		PFRModelType PFRModel() const { return pfr_model_; }
+		double PFRCascadeTolerance() const { return pfr_cascade_tolerance_; }
+		unsigned int PFRCascadeMaxCells() const { return pfr_cascade_max_cells_; }
+
+	private:
+
+		unsigned int number_of_threads_;
+
+		RecycleAccelerationType recycle_acceleration_;
+		double recycle_damping_;
+		unsigned int recycle_history_;
+		double recycle_tolerance_;
+		double recycle_absolute_tolerance_;
+		unsigned int recycle_max_iterations_;
+
+		NetworkSolverType network_solver_;
+		NewtonLinearSolverType newton_linear_solver_;
+		unsigned int newton_max_iterations_;
+		double newton_absolute_tolerance_;
+		double newton_relative_tolerance_;
+
+		unsigned int psr_batch_size_;
+		PSRJacobianType psr_jacobian_;
+		JacobianReusePolicy jacobian_reuse_;
+		double jacobian_cache_max_memory_;
+
+		AdaptiveChemistryType adaptive_chemistry_;
+		double adaptive_chemistry_threshold_;
+
+		bool isat_;
+		double isat_tolerance_;
+		double isat_max_memory_;
+
+		double checkpoint_interval_;
+
+		bool telemetry_;
+		bool telemetry_trace_;
+
+		PFRModelType pfr_model_;
+		double pfr_cascade_tolerance_;
+		unsigned int pfr_cascade_max_cells_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif	/* GRAMMAR_NETSMOKE_OPTIONS_H */
@@ -66,9 +66,10 @@ namespace NetSMOKE
 		std::string name;
 		dictionary.ReadString("@PhaseSplitter", name);
 		TempUnit.name = name;
+		TempUnit.tag = "PhaseSplitter";
 
 		std::vector<std::string> phases;
-		dictionary.ReadOption("OutletPhase", name);
+		dictionary.ReadOption("OutletPhase", phases);
 		TempUnit.outlet_phase = phases;
 
 		std::vector<int> outlets;
@@ -77,7 +78,7 @@ namespace NetSMOKE
 
 		int inlet;
 		dictionary.ReadInt("InletStream", inlet);
-		TempUnit.inlets = inlet;
+		TempUnit.inlets.push_back(inlet);
 
 		UnitsData.push_back(TempUnit);
 		
@@ -0,0 +1,324 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef GRAMMAR_NETSMOKE_REACTORBLOCKS_H
+#define	GRAMMAR_NETSMOKE_REACTORBLOCKS_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdlib>
+#include "boost/filesystem.hpp"
+#include "dictionary/OpenSMOKE_Dictionary.h"
+#include "dictionary/OpenSMOKE_DictionaryGrammar.h"
+#include "ReadErrors.h"
+
+namespace NetSMOKE
+{
+
+	class Grammar_NetSMOKE_ReactorBlocks : public OpenSMOKE::OpenSMOKE_DictionaryGrammar
+	{
+	protected:
+
+		virtual void DefineRules()
+		{
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("@ReactorBlock",
+																OpenSMOKE::SINGLE_STRING,
+																"Name of this block of reactors (reactor i is named <name>_i)",
+																true) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("Type",
+																OpenSMOKE::SINGLE_STRING,
+																"Type of the reactors of the block (PSR)",
+																true) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("Energy",
+																OpenSMOKE::SINGLE_STRING,
+																"Energy type of the reactors of the block (i.e. Isothermal, Adiabatic)",
+																true) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("UnitsFile",
+																OpenSMOKE::SINGLE_PATH,
+																"File with one line per reactor: volume [m3], temperature [K], pressure [Pa]",
+																true) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("FlowsFile",
+																OpenSMOKE::SINGLE_PATH,
+																"File with one line per internal stream: from reactor, to reactor (0-based), mass flow rate [kg/s]",
+																false) );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("FirstStreamID",
+																OpenSMOKE::SINGLE_INT,
+																"ID number of the first internal stream (the stream in line k of FlowsFile has ID FirstStreamID+k)",
+																false,
+																"none",
+																"FlowsFile",
+																"none") );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("InletStreams",
+																OpenSMOKE::VECTOR_INT,
+																"ID numbers of the streams entering the block, ordered as InletReactors",
+																false,
+																"none",
+																"InletReactors",
+																"none") );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("InletReactors",
+																OpenSMOKE::VECTOR_INT,
+																"Reactors (0-based) fed by the InletStreams",
+																false,
+																"none",
+																"InletStreams",
+																"none") );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("OutletStreams",
+																OpenSMOKE::VECTOR_INT,
+																"ID numbers of the streams leaving the block, ordered as OutletReactors",
+																false,
+																"none",
+																"OutletReactors",
+																"none") );
+
+			AddKeyWord( OpenSMOKE::OpenSMOKE_DictionaryKeyWord("OutletReactors",
+																OpenSMOKE::VECTOR_INT,
+																"Reactors (0-based) producing the OutletStreams",
+																false,
+																"none",
+																"OutletStreams",
+																"none") );
+		}
+	};
+
+	//! Bulk declaration of many reactors of the same type (i.e. from CFD clustering), stored as structure of arrays
+	struct ReactorBlock
+	{
+		std::string name;
+		std::string tag;
+		std::string energy;
+
+		std::vector<double> volume;
+		std::vector<double> temperature;
+		std::vector<double> pressure;
+
+		// Streams of each reactor (CSR)
+		std::vector<unsigned int> inlet_ptr;
+		std::vector<int> inlet_ids;
+		std::vector<unsigned int> outlet_ptr;
+		std::vector<int> outlet_ids;
+
+		// Internal streams with their mass flow rates [kg/s]
+		std::vector<int> flow_ids;
+		std::vector<double> flow_rates;
+
+		unsigned int NumberOfReactors() const { return static_cast<unsigned int>(volume.size()); }
+	};
+
+	//! Reads all the numbers of a text file (blanks as separators, # starts a comment)
+	inline void ReadNumericFile(const boost::filesystem::path& file_name, std::vector<double>& values)
+	{
+		std::ifstream fInput(file_name.c_str(), std::ios::in | std::ios::binary);
+		if (!fInput.is_open())
+			ReadErrorMessage("Unable to open file: " + file_name.string());
+
+		std::stringstream buffer;
+		buffer << fInput.rdbuf();
+		const std::string text = buffer.str();
+
+		values.clear();
+		values.reserve(text.size() / 8);
+
+		const char* p = text.c_str();
+		for (;;)
+		{
+			while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+				p++;
+			if (*p == '\0')
+				break;
+			if (*p == '#')
+			{
+				while (*p != '\n' && *p != '\0')	p++;
+				continue;
+			}
+
+			char* next;
+			const double value = std::strtod(p, &next);
+			if (next == p)
+				ReadErrorMessage("Wrong number in file " + file_name.string() + " at position " + std::to_string(p - text.c_str()));
+			values.push_back(value);
+			p = next;
+		}
+	}
+
+	//! set_grammar = false if the grammar of the dictionary was already set (i.e. before reading in parallel)
+	inline void GetReactorBlockDataFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, std::vector<NetSMOKE::ReactorBlock> &ReactorBlocks,
+													const bool set_grammar = true)
+	{
+		if (set_grammar == true)
+		{
+			Grammar_NetSMOKE_ReactorBlocks grammar_reactor_blocks;
+			dictionary.SetGrammar(grammar_reactor_blocks);
+		}
+
+		NetSMOKE::ReactorBlock block;
+
+		dictionary.ReadString("@ReactorBlock", block.name);
+		dictionary.ReadString("Type", block.tag);
+		dictionary.ReadString("Energy", block.energy);
+
+		if (block.tag != "PSR")
+			ReadErrorMessage("Reactor block " + block.name + ": only PSR blocks are supported");
+		if (block.energy != "Isothermal" && block.energy != "Adiabatic")
+			ReadErrorMessage("Reactor block " + block.name + ": Energy must be Isothermal or Adiabatic");
+
+		// Volumes, temperatures and pressures
+		{
+			boost::filesystem::path file_name;
+			dictionary.ReadPath("UnitsFile", file_name);
+
+			std::vector<double> values;
+			ReadNumericFile(file_name, values);
+			if (values.size() % 3 != 0)
+				ReadErrorMessage("UnitsFile of reactor block " + block.name + " must have 3 columns (volume, temperature, pressure)");
+
+			const unsigned int n = static_cast<unsigned int>(values.size() / 3);
+			block.volume.resize(n);
+			block.temperature.resize(n);
+			block.pressure.resize(n);
+			for (unsigned int i = 0; i < n; i++)
+			{
+				block.volume[i] = values[3 * i];
+				block.temperature[i] = values[3 * i + 1];
+				block.pressure[i] = values[3 * i + 2];
+				if (!(block.volume[i] > 0.) || !(block.temperature[i] > 0.) || !(block.pressure[i] > 0.))
+					ReadErrorMessage("UnitsFile of reactor block " + block.name + ", row " + std::to_string(i + 1) +
+												": volume, temperature and pressure must be positive");
+			}
+		}
+
+		const unsigned int n = block.NumberOfReactors();
+		std::vector<int> from, to, ids;
+
+		// Internal streams
+		if (dictionary.CheckOption("FlowsFile") == true)
+		{
+			boost::filesystem::path file_name;
+			dictionary.ReadPath("FlowsFile", file_name);
+
+			int first_id = 0;
+			if (dictionary.CheckOption("FirstStreamID") == true)
+				dictionary.ReadInt("FirstStreamID", first_id);
+
+			std::vector<double> values;
+			ReadNumericFile(file_name, values);
+			if (values.size() % 3 != 0)
+				ReadErrorMessage("FlowsFile of reactor block " + block.name + " must have 3 columns (from, to, mass flow rate)");
+
+			const unsigned int m = static_cast<unsigned int>(values.size() / 3);
+			block.flow_ids.resize(m);
+			block.flow_rates.resize(m);
+			for (unsigned int k = 0; k < m; k++)
+			{
+				for (unsigned int c = 0; c < 2; c++)
+				{
+					const double index = values[3 * k + c];
+					if (index != std::floor(index) || index < 0. || index >= static_cast<double>(n))
+						ReadErrorMessage("FlowsFile of reactor block " + block.name + ", row " + std::to_string(k + 1) +
+													": reactor indices must be integers between 0 and " + std::to_string(static_cast<int>(n) - 1));
+				}
+				from.push_back(static_cast<int>(values[3 * k]));
+				to.push_back(static_cast<int>(values[3 * k + 1]));
+				ids.push_back(first_id + static_cast<int>(k));
+				block.flow_ids[k] = first_id + static_cast<int>(k);
+				block.flow_rates[k] = values[3 * k + 2];
+			}
+		}
+
+		// Streams entering and leaving the block
+		{
+			const auto check_reactors = [&](const std::vector<int>& reactors, const std::string& keyword)
+			{
+				for (unsigned int k = 0; k < reactors.size(); k++)
+					if (reactors[k] < 0 || reactors[k] >= static_cast<int>(n))
+						ReadErrorMessage(keyword + " of reactor block " + block.name + ": reactor indices must be between 0 and " +
+													std::to_string(static_cast<int>(n) - 1));
+			};
+
+			std::vector<int> streams, reactors;
+			if (dictionary.CheckOption("InletStreams") == true)
+			{
+				dictionary.ReadOption("InletStreams", streams);
+				dictionary.ReadOption("InletReactors", reactors);
+				if (streams.size() != reactors.size())
+					ReadErrorMessage("InletStreams and InletReactors of reactor block " + block.name + " must have the same length");
+				check_reactors(reactors, "InletReactors");
+				for (unsigned int k = 0; k < streams.size(); k++)
+				{
+					from.push_back(-1);
+					to.push_back(reactors[k]);
+					ids.push_back(streams[k]);
+				}
+			}
+			if (dictionary.CheckOption("OutletStreams") == true)
+			{
+				dictionary.ReadOption("OutletStreams", streams);
+				dictionary.ReadOption("OutletReactors", reactors);
+				if (streams.size() != reactors.size())
+					ReadErrorMessage("OutletStreams and OutletReactors of reactor block " + block.name + " must have the same length");
+				check_reactors(reactors, "OutletReactors");
+				for (unsigned int k = 0; k < streams.size(); k++)
+				{
+					from.push_back(reactors[k]);
+					to.push_back(-1);
+					ids.push_back(streams[k]);
+				}
+			}
+		}
+
+		// Counting sort of the streams into the CSR of each reactor
+		block.inlet_ptr.assign(n + 1, 0);
+		block.outlet_ptr.assign(n + 1, 0);
+		for (unsigned int k = 0; k < ids.size(); k++)
+		{
+			if (from[k] >= static_cast<int>(n) || to[k] >= static_cast<int>(n) || from[k] < -1 || to[k] < -1)
+				ReadErrorMessage("Reactor block " + block.name + ": stream " + std::to_string(ids[k]) + " refers to a reactor out of range");
+			if (to[k] >= 0)		block.inlet_ptr[to[k] + 1]++;
+			if (from[k] >= 0)	block.outlet_ptr[from[k] + 1]++;
+		}
+		for (unsigned int i = 0; i < n; i++)
+		{
+			block.inlet_ptr[i + 1] += block.inlet_ptr[i];
+			block.outlet_ptr[i + 1] += block.outlet_ptr[i];
+		}
+
+		block.inlet_ids.resize(block.inlet_ptr[n]);
+		block.outlet_ids.resize(block.outlet_ptr[n]);
+		std::vector<unsigned int> inlet_position(block.inlet_ptr.begin(), block.inlet_ptr.end() - 1);
+		std::vector<unsigned int> outlet_position(block.outlet_ptr.begin(), block.outlet_ptr.end() - 1);
+		for (unsigned int k = 0; k < ids.size(); k++)
+		{
+			if (to[k] >= 0)		block.inlet_ids[inlet_position[to[k]]++] = ids[k];
+			if (from[k] >= 0)	block.outlet_ids[outlet_position[from[k]]++] = ids[k];
+		}
+
+		ReactorBlocks.push_back(block);
+	}
+
+} // End namespace NetSMOKE
+
+#endif	/* GRAMMAR_NETSMOKE_REACTORBLOCKS_H */
@@ -22,6 +22,7 @@
 #include "boost/filesystem.hpp"
 #include "dictionary/OpenSMOKE_Dictionary.h"
 #include "dictionary/OpenSMOKE_DictionaryGrammar.h"
+#include "MeasureUnits.h"
 
 namespace NetSMOKE
 {
@@ -165,16 +166,10 @@ namespace NetSMOKE
 		{
 			if (dictionary.CheckOption("Temperature") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("Temperature", value, units);
-		
-				if (units == "K")			TempUnit.temperature = value;
-				else if (units == "C")		TempUnit.temperature = value + 273.15;
-				else OpenSMOKE::FatalErrorMessage("Unknown temperature units");
+				TempUnit.temperature = ReadQuantity<DIMENSION_TEMPERATURE>(dictionary, "Temperature").value;
 
 			}
-			else OpenSMOKE::FatalErrorMessage("Missing temperature keyword for reactor " + TempUnit.name);
+			else ReadErrorMessage("Missing temperature keyword for reactor " + TempUnit.name);
 		}
 		else if (TempUnit.energy == "Adiabatic")
 		{
@@ -184,109 +179,71 @@ namespace NetSMOKE
 		{
 			if (dictionary.CheckOption("UA") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("UA", value, units);
-		
-				if (units == "W/K")			TempUnit.UA = value;
-				else OpenSMOKE::FatalErrorMessage("Unknown temperature units, use W/K");
+				TempUnit.UA = ReadQuantity<DIMENSION_THERMAL_CONDUCTANCE>(dictionary, "UA").value;
 
 			}
-			else OpenSMOKE::FatalErrorMessage("Missing UA keyword for reactor " + TempUnit.name);
+			else ReadErrorMessage("Missing UA keyword for reactor " + TempUnit.name);
 		}
 
 		// Pressure
 		{
 			if (dictionary.CheckOption("Pressure") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("Pressure", value, units);
-
-				if (units == "Pa")			TempUnit.pressure = value;
-				else if (units == "bar")	TempUnit.pressure = value*1.e5;
-				else if (units == "atm")	TempUnit.pressure = value*101325.;
-				else OpenSMOKE::FatalErrorMessage("Unknown pressure units");
+				TempUnit.pressure = ReadQuantity<DIMENSION_PRESSURE>(dictionary, "Pressure").value;
 			}
 		}
 
 		// Residence time and geometry
 		if (dictionary.CheckOption("ResidenceTime") == true)
 		{
-			double value;
-			std::string units;
-			dictionary.ReadMeasure("ResidenceTime", value, units);
-
-			if (units == "s")			TempUnit.residence_time = value;
-			else if (units == "min")	TempUnit.residence_time = value*60;
-			else if (units == "hr")		TempUnit.residence_time = value*3600;
-			else OpenSMOKE::FatalErrorMessage("Unknown residence time units");
+			TempUnit.residence_time = ReadQuantity<DIMENSION_TIME>(dictionary, "ResidenceTime").value;
 
-			if (TempUnit.type == "PSR")
+			if (TempUnit.tag == "PSR")
 				TempUnit.volume = -1;
-			else if (TempUnit.type == "PFR")
+			else if (TempUnit.tag == "PFR")
 				TempUnit.diameter = -1;
 				TempUnit.length = -1;
 		}
-		else if (TempUnit.type == "PSR")
+		else if (TempUnit.tag == "PSR")
 		{
 			if (dictionary.CheckOption("Volume") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("Volume", value, units);
-
-				if (units == "m3")			TempUnit.volume = value;
-				else if (units == "cm3")	TempUnit.volume = value/1000000;
-				else if (units == "l")		TempUnit.volume = value/1000;
-				else OpenSMOKE::FatalErrorMessage("Unknown volume units (use m3,cm3,l)");
+				TempUnit.volume = ReadQuantity<DIMENSION_VOLUME>(dictionary, "Volume").value;
 				TempUnit.residence_time = -1;
 			}
 		}
-		else if (TempUnit.type == "PFR")
+		else if (TempUnit.tag == "PFR")
 		{
 			if (dictionary.CheckOption("Diameter") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("Diameter", value, units);
-
-				if (units == "m")			TempUnit.diameter = value;
-				else if (units == "cm")	TempUnit.diameter = value/100;
-				else OpenSMOKE::FatalErrorMessage("Unknown diameter units (use m,cm)");
+				TempUnit.diameter = ReadQuantity<DIMENSION_LENGTH>(dictionary, "Diameter").value;
 				TempUnit.residence_time = -1;
 			}
-			else OpenSMOKE::FatalErrorMessage("Missing diameter for reactor " + TempUnit.name);
+			else ReadErrorMessage("Missing diameter for reactor " + TempUnit.name);
 
 			if (dictionary.CheckOption("Length") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("Length", value, units);
-
-				if (units == "m")			TempUnit.length = value;
-				else if (units == "cm")	TempUnit.length = value/100;
-				else OpenSMOKE::FatalErrorMessage("Unknown length units (use m,cm)");
+				TempUnit.length = ReadQuantity<DIMENSION_LENGTH>(dictionary, "Length").value;
 				TempUnit.residence_time = -1;
 			}
-			else OpenSMOKE::FatalErrorMessage("Missing length for reactor " + TempUnit.name);
+			else ReadErrorMessage("Missing length for reactor " + TempUnit.name);
 		}
 		
 		// Inlets and outlets
-		if (dictionary.CheckOption("Inlet") == true)
+		if (dictionary.CheckOption("InletStream") == true)
 		{
-			double value;
-			dictionary.ReadInt("Inlet", value);
-			TempUnit.inlets.push_back();
+			int value;
+			dictionary.ReadInt("InletStream", value);
+			TempUnit.inlets.push_back(value);
 		}
-		if (dictionary.CheckOption("Outlet") == true)
+		if (dictionary.CheckOption("OutletStream") == true)
 		{
-			double value;
-			dictionary.ReadInt("Outlet", value);
-			TempUnit.outlets.push_back();
+			int value;
+			dictionary.ReadInt("OutletStream", value);
+			TempUnit.outlets.push_back(value);
 		}
 
-		Units.push_back(TempUnit);
+		UnitsData.push_back(TempUnit);
 
 	}
 
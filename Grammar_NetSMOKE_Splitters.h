@@ -41,6 +41,8 @@
 #include "boost/filesystem.hpp"
 #include "dictionary/OpenSMOKE_Dictionary.h"
 #include "dictionary/OpenSMOKE_DictionaryGrammar.h"
+#include "MeasureUnits.h"
+#include "SpeciesIndexMap.h"
 
 namespace OpenSMOKE
 {
@@ -112,7 +114,7 @@ namespace OpenSMOKE
 	};
 
 	template<typename Thermodynamics>
-	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML,
+	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML, const NetSMOKE::SpeciesIndexMap& species_index,
 									double& T, double& P_Pa, OpenSMOKE::OpenSMOKEVectorDouble& omega)
 	{
 		Grammar_GasStatus grammar_gas_status;
@@ -127,13 +129,7 @@ namespace OpenSMOKE
 		{
 			if (dictionary.CheckOption("@Temperature") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Temperature", value, units);
-		
-				if (units == "K")			T = value;
-				else if (units == "C")		T = value + 273.15;
-				else OpenSMOKE::FatalErrorMessage("Unknown temperature units");
+				T = NetSMOKE::ReadQuantity<NetSMOKE::DIMENSION_TEMPERATURE>(dictionary, "@Temperature").value;
 
 				state_variables++;
 				temperature_assigned = true;
@@ -144,14 +140,7 @@ namespace OpenSMOKE
 		{
 			if (dictionary.CheckOption("@Pressure") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Pressure", value, units);
-
-				if (units == "Pa")			P_Pa = value;
-				else if (units == "bar")	P_Pa = value*1.e5;
-				else if (units == "atm")	P_Pa = value*101325.;
-				else OpenSMOKE::FatalErrorMessage("Unknown pressure units");
+				P_Pa = NetSMOKE::ReadQuantity<NetSMOKE::DIMENSION_PRESSURE>(dictionary, "@Pressure").value;
 
 				state_variables++;
 				pressure_assigned = true;
@@ -163,13 +152,7 @@ namespace OpenSMOKE
 		{
 			if (dictionary.CheckOption("@Density") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Density", value, units);
-
-				if (units == "kg/m3")		rho = value;
-				else if (units == "g/cm3")	rho = value*1.e3;
-				else OpenSMOKE::FatalErrorMessage("Unknown density units");
+				rho = NetSMOKE::ReadQuantity<NetSMOKE::DIMENSION_DENSITY>(dictionary, "@Density").value;
 
 				state_variables++;
 				density_assigned = true;
@@ -184,10 +167,12 @@ namespace OpenSMOKE
 			{
 				std::vector<std::string> names;
 				std::vector<double> values;
+				std::vector<unsigned int> indices;
 		
 				if (dictionary.CheckOption("@MoleFractions") == true)
 				{
 					dictionary.ReadOption("@MoleFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 				
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					if (sum<(1.-1e-6) || sum>(1.+1e-6))
@@ -195,7 +180,7 @@ namespace OpenSMOKE
 
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for(unsigned int i=0;i<names.size();i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						x[indices[i]] = values[i]/sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega.GetHandle(),MW,x.GetHandle());
@@ -203,6 +188,7 @@ namespace OpenSMOKE
 				else if (dictionary.CheckOption("@MassFractions") == true)
 				{
 					dictionary.ReadOption("@MassFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					if (sum<(1.-1e-6) || sum>(1.+1e-6))
@@ -210,15 +196,16 @@ namespace OpenSMOKE
 
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					for(unsigned int i=0;i<names.size();i++)
-						omega[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						omega[indices[i]] = values[i]/sum;
 				}
 				else if (dictionary.CheckOption("@Moles") == true)
 				{
 					dictionary.ReadOption("@Moles", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for(unsigned int i=0;i<names.size();i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						x[indices[i]] = values[i]/sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega.GetHandle(),MW,x.GetHandle());
@@ -226,10 +213,11 @@ namespace OpenSMOKE
 				else if (dictionary.CheckOption("@Masses") == true)
 				{
 					dictionary.ReadOption("@Masses", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum =std::accumulate(values.begin(),values.end(),0.);
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega, true);
 					for(unsigned int i=0;i<names.size();i++)
-						omega[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i]/sum;
+						omega[indices[i]] = values[i]/sum;
 				}
 			}
 		}
@@ -243,7 +231,7 @@ namespace OpenSMOKE
 	}
 
 	template<typename Thermodynamics>
-	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML,
+	void GetGasStatusFromDictionary(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, Thermodynamics& thermodynamicsMapXML, const NetSMOKE::SpeciesIndexMap& species_index,
 		std::vector<double>& T, std::vector<double>& P_Pa, std::vector<OpenSMOKE::OpenSMOKEVectorDouble>& omega, std::vector<double>& equivalence_ratios)
 	{
 		Grammar_GasStatus grammar_gas_status;
@@ -259,13 +247,7 @@ namespace OpenSMOKE
 			T.resize(1);
 			if (dictionary.CheckOption("@Temperature") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Temperature", value, units);
-
-				if (units == "K")			T[0] = value;
-				else if (units == "C")		T[0] = value + 273.15;
-				else OpenSMOKE::FatalErrorMessage("Unknown temperature units");
+				T[0] = NetSMOKE::ReadQuantity<NetSMOKE::DIMENSION_TEMPERATURE>(dictionary, "@Temperature").value;
 
 				state_variables++;
 				temperature_assigned = true;
@@ -277,14 +259,7 @@ namespace OpenSMOKE
 			P_Pa.resize(1);
 			if (dictionary.CheckOption("@Pressure") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Pressure", value, units);
-
-				if (units == "Pa")			P_Pa[0] = value;
-				else if (units == "bar")	P_Pa[0] = value*1.e5;
-				else if (units == "atm")	P_Pa[0] = value*101325.;
-				else OpenSMOKE::FatalErrorMessage("Unknown pressure units");
+				P_Pa[0] = NetSMOKE::ReadQuantity<NetSMOKE::DIMENSION_PRESSURE>(dictionary, "@Pressure").value;
 
 				state_variables++;
 				pressure_assigned = true;
@@ -296,13 +271,7 @@ namespace OpenSMOKE
 		{
 			if (dictionary.CheckOption("@Density") == true)
 			{
-				double value;
-				std::string units;
-				dictionary.ReadMeasure("@Density", value, units);
-
-				if (units == "kg/m3")		rho = value;
-				else if (units == "g/cm3")	rho = value*1.e3;
-				else OpenSMOKE::FatalErrorMessage("Unknown density units");
+				rho = NetSMOKE::ReadQuantity<NetSMOKE::DIMENSION_DENSITY>(dictionary, "@Density").value;
 
 				state_variables++;
 				density_assigned = true;
@@ -317,12 +286,14 @@ namespace OpenSMOKE
 			{
 				std::vector<std::string> names;
 				std::vector<double> values;
+				std::vector<unsigned int> indices;
 
 				if (dictionary.CheckOption("@MoleFractions") == true)
 				{
 					omega.resize(1);
 
 					dictionary.ReadOption("@MoleFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					if (sum<(1. - 1e-6) || sum>(1. + 1e-6))
@@ -330,7 +301,7 @@ namespace OpenSMOKE
 
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for (unsigned int i = 0; i<names.size(); i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						x[indices[i]] = values[i] / sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega[0].GetHandle(), MW, x.GetHandle());
@@ -340,6 +311,7 @@ namespace OpenSMOKE
 					omega.resize(1);
 
 					dictionary.ReadOption("@MassFractions", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					if (sum<(1. - 1e-6) || sum>(1. + 1e-6))
@@ -347,17 +319,18 @@ namespace OpenSMOKE
 
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					for (unsigned int i = 0; i<names.size(); i++)
-						omega[0][thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						omega[0][indices[i]] = values[i] / sum;
 				}
 				else if (dictionary.CheckOption("@Moles") == true)
 				{
 					omega.resize(1);
 
 					dictionary.ReadOption("@Moles", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					OpenSMOKE::OpenSMOKEVectorDouble x(thermodynamicsMapXML.NumberOfSpecies());
 					for (unsigned int i = 0; i<names.size(); i++)
-						x[thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						x[indices[i]] = values[i] / sum;
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					double MW;
 					thermodynamicsMapXML.MassFractions_From_MoleFractions(omega[0].GetHandle(), MW, x.GetHandle());
@@ -366,10 +339,11 @@ namespace OpenSMOKE
 				{
 					omega.resize(1);
 					dictionary.ReadOption("@Masses", names, values);
+					species_index.IndicesOfSpecies(names, indices);
 					const double sum = std::accumulate(values.begin(), values.end(), 0.);
 					ChangeDimensions(thermodynamicsMapXML.NumberOfSpecies(), &omega[0], true);
 					for (unsigned int i = 0; i<names.size(); i++)
-						omega[0][thermodynamicsMapXML.IndexOfSpecies(names[i])] = values[i] / sum;
+						omega[0][indices[i]] = values[i] / sum;
 				}
 			}
 		}
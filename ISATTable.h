@@ -0,0 +1,382 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_ISATTABLE_H
+#define NETSMOKE_ISATTABLE_H
+
+#include <vector>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include <algorithm>
+#include "Eigen/Dense"
+
+namespace NetSMOKE
+{
+	//! Query point of a PSR map: inlet mass fractions, T_in/1000 K, ln(P/Pa), ln(tau/s)
+	/*!
+		 The coordinates are chosen so that a unit change has a comparable meaning in all the
+		 directions (temperature in thousands of K, relative changes of pressure and residence time).
+	*/
+	inline void EncodePSRInput(const unsigned int ns, const double* omega_in, const double T_in, const double P, const double tau, std::vector<double>& x)
+	{
+		x.resize(ns + 3);
+		for (unsigned int i = 0; i < ns; i++)
+			x[i] = omega_in[i];
+		x[ns] = T_in / 1000.;
+		x[ns + 1] = std::log(P);
+		x[ns + 2] = std::log(tau);
+	}
+
+	inline void DecodePSRInput(const std::vector<double>& x, const unsigned int ns, double* omega_in, double& T_in, double& P, double& tau)
+	{
+		for (unsigned int i = 0; i < ns; i++)
+			omega_in[i] = x[i];
+		T_in = 1000. * x[ns];
+		P = std::exp(x[ns + 1]);
+		tau = std::exp(x[ns + 2]);
+	}
+
+	//! Mapped value of a PSR: outlet mass fractions, T/1000 K
+	inline void EncodePSROutput(const unsigned int ns, const double* omega, const double T, std::vector<double>& y)
+	{
+		y.resize(ns + 1);
+		for (unsigned int i = 0; i < ns; i++)
+			y[i] = omega[i];
+		y[ns] = T / 1000.;
+	}
+
+	inline void DecodePSROutput(const std::vector<double>& y, const unsigned int ns, double* omega, double& T)
+	{
+		for (unsigned int i = 0; i < ns; i++)
+			omega[i] = std::max(0., y[i]);
+		T = 1000. * y[ns];
+	}
+
+	//!  In situ adaptive tabulation of a reactor map y = R(x)
+	/*!
+		 Every record stores a query point x0, the mapped value y0, the mapping gradient
+		 A = dR/dx and an ellipsoid of accuracy {x: (x-x0)' M (x-x0) <= 1} where the linear
+		 approximation y0 + A(x-x0) is within the tolerance. The records are the leaves of a
+		 binary tree of cutting planes (Pope, 1997).
+		 For a query the tree is traversed to a leaf: if x lies in its ellipsoid the mapping is
+		 retrieved, otherwise the reactor is solved directly and the record is either grown (the
+		 linear approximation was accurate) or a new record is added, with the gradient given by
+		 the reactor map at its solution. Once the memory limit is reached, no more records are
+		 added.
+		 M is stored in low-rank form, M = I/r^2 + V diag(lambda) V' (V orthonormal, r radius of
+		 the largest ellipsoid): the singular directions of A/tolerance below the ball 1/r are
+		 dropped when the record is added, and every growth adds at most one direction.
+		 The table is shared by all the reactors and threads: the reactor solutions are
+		 computed outside the lock.
+
+		 The ReactorMap must provide
+		 - void operator()(const std::vector<double>& x, std::vector<double>& y)
+		 - void Gradient(const std::vector<double>& x, const std::vector<double>& y, Eigen::MatrixXd& A)
+		 Gradient is called just after operator() at the same x: for a PSR solved with Newton's
+		 method A = -(dF/dy)^-1 dF/dx, from the Jacobian at the solution (see
+		 SparsePSRSolver::Sensitivities, scaled to the coordinates of EncodePSRInput/EncodePSROutput).
+	*/
+	class ISATTable
+	{
+	public:
+
+		ISATTable(const unsigned int nx, const unsigned int ny, const double tolerance, const double max_memory_MB) :
+			nx_(nx),
+			ny_(ny),
+			tolerance_(tolerance),
+			max_bytes_(max_memory_MB * 1024. * 1024.),
+			bytes_(0.),
+			queries_(0),
+			retrieves_(0),
+			grows_(0),
+			adds_(0),
+			direct_evaluations_(0)
+		{
+		}
+
+		template<typename ReactorMap>
+		void Evaluate(const std::vector<double>& x, std::vector<double>& y, ReactorMap& map)
+		{
+			queries_++;
+			const Eigen::Map<const Eigen::VectorXd> xq(&x[0], nx_);
+			y.resize(ny_);
+			Eigen::Map<Eigen::VectorXd> yq(&y[0], ny_);
+
+			// Retrieve
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				const int r = Leaf(xq);
+				if (r >= 0 && Inside(records_[r], xq) == true)
+				{
+					const Record& record = records_[r];
+					yq = record.y + record.A * (xq - record.x);
+					retrieves_++;
+					return;
+				}
+			}
+
+			// Direct evaluation outside the lock
+			map(x, y);
+			direct_evaluations_++;
+
+			// Grow
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				const int r = Leaf(xq);
+				if (r >= 0)
+				{
+					Record& record = records_[r];
+					const double error = (yq - record.y - record.A * (xq - record.x)).norm();
+					if (error <= tolerance_)
+					{
+						Grow(record, xq);
+						grows_++;
+						return;
+					}
+				}
+				if (bytes_ >= max_bytes_)
+					return;
+			}
+
+			// Add: the gradient at the solution just computed, outside the lock
+			Eigen::MatrixXd A(ny_, nx_);
+			map.Gradient(x, y, A);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (bytes_ < max_bytes_)
+				{
+					Add(xq, yq, A);
+					adds_++;
+				}
+			}
+		}
+
+		unsigned int NumberOfRecords() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return static_cast<unsigned int>(records_.size());
+		}
+
+		//! Memory used by the records [MB]
+		double MemoryMB() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return bytes_ / 1024. / 1024.;
+		}
+
+		unsigned long long Queries() const { return queries_; }
+		unsigned long long Retrieves() const { return retrieves_; }
+		unsigned long long Grows() const { return grows_; }
+		unsigned long long Adds() const { return adds_; }
+		unsigned long long DirectEvaluations() const { return direct_evaluations_; }
+
+		void Summary(std::ostream& out) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			const double q = std::max(1., static_cast<double>(queries_));
+			out << std::endl;
+			out << "ISAT statistics" << std::endl;
+			out << " * Queries:              " << queries_ << std::endl;
+			out << " * Retrieves:            " << retrieves_ << " (" << 100. * retrieves_ / q << "%)" << std::endl;
+			out << " * Grows:                " << grows_ << " (" << 100. * grows_ / q << "%)" << std::endl;
+			out << " * Adds:                 " << adds_ << " (" << 100. * adds_ / q << "%)" << std::endl;
+			out << " * Direct evaluations:   " << direct_evaluations_ << std::endl;
+			out << " * Records:              " << records_.size() << " (" << bytes_ / 1024. / 1024. << " MB of " << max_bytes_ / 1024. / 1024. << " MB)" << std::endl;
+			out << std::endl;
+		}
+
+	private:
+
+		//! M = I/r^2 + V diag(lambda) V'
+		struct Record
+		{
+			Eigen::VectorXd x;
+			Eigen::VectorXd y;
+			Eigen::MatrixXd A;
+			Eigen::MatrixXd V;
+			Eigen::VectorXd lambda;
+		};
+
+		static double MaxRadius() { return 0.1; }
+
+		double Bytes(const Record& record) const
+		{
+			return sizeof(double) * (2. * nx_ + ny_ + double(ny_) * nx_ + double(record.V.size()) + record.lambda.size()) + sizeof(Record) + 2. * sizeof(Node);
+		}
+
+		//! Leaf (record >= 0) or cutting plane v'x > a (right) / <= a (left)
+		struct Node
+		{
+			int record;
+			int left;
+			int right;
+			Eigen::VectorXd v;
+			double a;
+		};
+
+		//! Record of the leaf reached by x (-1 if the table is empty)
+		int Leaf(const Eigen::Map<const Eigen::VectorXd>& x) const
+		{
+			if (nodes_.empty() == true)
+				return -1;
+
+			int n = 0;
+			while (nodes_[n].record < 0)
+				n = (nodes_[n].v.dot(x) > nodes_[n].a) ? nodes_[n].right : nodes_[n].left;
+			return nodes_[n].record;
+		}
+
+		bool Inside(const Record& record, const Eigen::Map<const Eigen::VectorXd>& x) const
+		{
+			const Eigen::VectorXd dx = x - record.x;
+			const Eigen::VectorXd p = record.V.transpose() * dx;
+			return dx.squaredNorm() / (MaxRadius() * MaxRadius()) + p.dot(record.lambda.cwiseProduct(p)) <= 1.;
+		}
+
+		//! Rank-one update of the ellipsoid of accuracy so that it contains x
+		/*!
+			 M' = M - (alpha^2 - 1)/alpha^4 u u', with u = M dx and alpha^2 = dx' M dx. Since u lies
+			 in the span of V and dx, the update is the eigendecomposition of a small matrix on
+			 the orthonormal basis W = [V q] (q: the part of dx orthogonal to V).
+		*/
+		void Grow(Record& record, const Eigen::Map<const Eigen::VectorXd>& x)
+		{
+			const double ball = 1. / (MaxRadius() * MaxRadius());
+			const Eigen::VectorXd dx = x - record.x;
+			const Eigen::VectorXd p = record.V.transpose() * dx;
+			const double alpha2 = ball * dx.squaredNorm() + p.dot(record.lambda.cwiseProduct(p));
+			if (alpha2 <= 1.)
+				return;
+
+			const long m = record.V.cols();
+			const Eigen::VectorXd q = dx - record.V * p;
+			const bool extend = (q.norm() > 1.e-12 * dx.norm());
+			const long k = extend ? m + 1 : m;
+
+			Eigen::MatrixXd W(nx_, k);
+			W.leftCols(m) = record.V;
+			Eigen::VectorXd d(k), u(k);
+			d.head(m) = p;
+			if (extend == true)
+			{
+				W.col(m) = q / q.norm();
+				d(m) = q.norm();
+			}
+			u = ball * d;
+			u.head(m) += record.lambda.cwiseProduct(p);
+
+			Eigen::MatrixXd S = -((alpha2 - 1.) / (alpha2 * alpha2)) * u * u.transpose();
+			S.diagonal().head(m) += record.lambda;
+			Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(S);
+			SetLowRank(record, W * eigen.eigenvectors(), eigen.eigenvalues());
+		}
+
+		//! Keeps the directions of V whose lambda is not negligible with respect to the ball
+		void SetLowRank(Record& record, const Eigen::MatrixXd& V, const Eigen::VectorXd& lambda)
+		{
+			const double cutoff = 1.e-12 / (MaxRadius() * MaxRadius());
+			std::vector<long> kept;
+			for (long j = 0; j < lambda.size(); j++)
+				if (std::fabs(lambda(j)) > cutoff)
+					kept.push_back(j);
+
+			const double before = Bytes(record);
+			record.V.resize(nx_, kept.size());
+			record.lambda.resize(kept.size());
+			for (unsigned int j = 0; j < kept.size(); j++)
+			{
+				record.V.col(j) = V.col(kept[j]);
+				record.lambda(j) = lambda(kept[j]);
+			}
+			bytes_ += Bytes(record) - before;
+		}
+
+		void Add(const Eigen::Map<const Eigen::VectorXd>& x, const Eigen::Map<Eigen::VectorXd>& y, const Eigen::MatrixXd& A)
+		{
+			// Initial ellipsoid: |A dx| <= tolerance, bounded by a ball of radius MaxRadius; the singular
+			// directions of A with sigma < tolerance/MaxRadius are within the tolerance on the whole ball
+			Record record;
+			record.x = x;
+			record.y = y;
+			record.A = A;
+			bytes_ += Bytes(record);
+
+			Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(A.transpose() * A / (tolerance_ * tolerance_));
+			const Eigen::VectorXd& sigma2 = eigen.eigenvalues();
+			long first = 0;
+			while (first < sigma2.size() && sigma2(first) <= 1. / (MaxRadius() * MaxRadius()))
+				first++;
+			SetLowRank(record, eigen.eigenvectors().rightCols(sigma2.size() - first), sigma2.tail(sigma2.size() - first));
+
+			const int r = static_cast<int>(records_.size());
+			records_.push_back(record);
+
+			Node leaf;
+			leaf.record = r;
+			leaf.left = leaf.right = -1;
+			leaf.a = 0.;
+
+			if (nodes_.empty() == true)
+			{
+				nodes_.push_back(leaf);
+				return;
+			}
+
+			// The leaf reached by x becomes a cutting plane between its record and the new one
+			int n = 0;
+			while (nodes_[n].record < 0)
+				n = (nodes_[n].v.dot(x) > nodes_[n].a) ? nodes_[n].right : nodes_[n].left;
+
+			Node old_leaf = nodes_[n];
+			const Eigen::VectorXd& x_old = records_[old_leaf.record].x;
+
+			Node& plane = nodes_[n];
+			plane.record = -1;
+			plane.v = x - x_old;
+			plane.a = 0.5 * plane.v.dot(x + x_old);
+			plane.left = static_cast<int>(nodes_.size());
+			plane.right = static_cast<int>(nodes_.size()) + 1;
+
+			nodes_.push_back(old_leaf);
+			nodes_.push_back(leaf);
+		}
+
+	private:
+
+		unsigned int nx_;
+		unsigned int ny_;
+		double tolerance_;
+		double max_bytes_;
+		double bytes_;
+
+		std::vector<Record> records_;
+		std::vector<Node> nodes_;
+		mutable std::mutex mutex_;
+
+		std::atomic<unsigned long long> queries_;
+		std::atomic<unsigned long long> retrieves_;
+		std::atomic<unsigned long long> grows_;
+		std::atomic<unsigned long long> adds_;
+		std::atomic<unsigned long long> direct_evaluations_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_ISATTABLE_H */
@@ -0,0 +1,126 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+
+#ifndef NETSMOKE_JACOBIANREUSE_H
+#define NETSMOKE_JACOBIANREUSE_H
+
+#include <vector>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+
+namespace NetSMOKE
+{
+	//! When a Jacobian (or its factorization) can be reused instead of being evaluated again
+	struct JacobianReusePolicy
+	{
+		JacobianReusePolicy() : enabled(false), max_convergence_rate(0.5), max_age(20), max_dt_ratio(10.), similarity(0.02) {}
+
+		bool enabled;
+		double max_convergence_rate;	// Newton contraction ||f_k+1||/||f_k|| above which the Jacobian is refreshed
+		unsigned int max_age;			// Newton iterations after which the Jacobian is refreshed anyway
+		double max_dt_ratio;			// pseudo-time step change after which the matrix is factorized again
+		double similarity;				// max distance of the states for seeding a Jacobian from another one
+	};
+
+	//! Distance between two states (mass fractions and temperature): max(|omega_a-omega_b|, |T_a-T_b|/T_b)
+	inline double StateDistance(const double* a, const double* b, const unsigned int ns)
+	{
+		double d = std::fabs(a[ns] - b[ns]) / std::max(std::fabs(b[ns]), 1.);
+		for (unsigned int i = 0; i < ns; i++)
+			d = std::max(d, std::fabs(a[i] - b[i]));
+		return d;
+	}
+
+	//!  Last Jacobian of every reactor, kept across the sweeps of the network
+	/*!
+		 For each unit the values of the Jacobian (in the order of the sparse pattern shared by
+		 all the reactors) are stored together with the state at which they were evaluated, so
+		 that the next solution of the same reactor (next recycle sweep) or of a similar reactor
+		 can start from them. The factorizations are not stored: the LU factors have far more
+		 non-zeros than the Jacobian (fill-in), and the matrix factorized also depends on the
+		 residence time and on the pseudo-time step, which change at the next solution.
+		 Different threads can store and look up different units concurrently; the memory
+		 limit only stops new units from entering the cache.
+	*/
+	class JacobianCache
+	{
+	public:
+
+		JacobianCache(const unsigned int number_of_units, const unsigned int number_of_equations, const unsigned int number_of_nonzeros, const double max_memory_MB) :
+			ne_(number_of_equations),
+			nnz_(number_of_nonzeros),
+			entries_(number_of_units),
+			stored_(0)
+		{
+			const double bytes_per_unit = sizeof(double) * (static_cast<double>(ne_) + nnz_);
+			max_units_ = static_cast<unsigned int>(std::min(static_cast<double>(number_of_units), max_memory_MB * 1024. * 1024. / bytes_per_unit));
+		}
+
+		unsigned int NumberOfEquations() const { return ne_; }
+		unsigned int NumberOfNonZeros() const { return nnz_; }
+		unsigned int NumberOfStoredUnits() const { return stored_; }
+
+		//! Stores the Jacobian of unit evaluated at state y (false if the memory limit is reached)
+		bool Store(const unsigned int unit, const double* y, const double* values)
+		{
+			Entry& entry = entries_[unit];
+			if (entry.state.empty() == true)
+			{
+				if (stored_.fetch_add(1) >= max_units_)
+				{
+					stored_--;
+					return false;
+				}
+				entry.state.resize(ne_);
+				entry.values.resize(nnz_);
+			}
+			std::copy(y, y + ne_, entry.state.begin());
+			std::copy(values, values + nnz_, entry.values.begin());
+			return true;
+		}
+
+		//! Jacobian of unit (and the state where it was evaluated) if that state is within max_distance from y
+		bool Lookup(const unsigned int unit, const double* y, const double max_distance, double* state, double* values) const
+		{
+			const Entry& entry = entries_[unit];
+			if (entry.state.empty() == true || StateDistance(y, &entry.state[0], ne_ - 1) > max_distance)
+				return false;
+			std::copy(entry.state.begin(), entry.state.end(), state);
+			std::copy(entry.values.begin(), entry.values.end(), values);
+			return true;
+		}
+
+	private:
+
+		struct Entry
+		{
+			std::vector<double> state;
+			std::vector<double> values;
+		};
+
+		unsigned int ne_;
+		unsigned int nnz_;
+		unsigned int max_units_;
+		std::vector<Entry> entries_;
+		std::atomic<unsigned int> stored_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_JACOBIANREUSE_H */
@@ -0,0 +1,109 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_KINETICSPREPROCESSORCACHE_H
+#define NETSMOKE_KINETICSPREPROCESSORCACHE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include "boost/filesystem.hpp"
+#include "NetworkCache.h"
+
+namespace NetSMOKE
+{
+	//! Hash of the content of a file (FNV-1a, see NetworkCache.h)
+	inline uint64_t HashFile(const boost::filesystem::path& file_name, uint64_t hash = HashBytes(0, 0))
+	{
+		std::ifstream fInput(file_name.c_str(), std::ios::in | std::ios::binary);
+		if (!fInput.is_open())
+			OpenSMOKE::FatalErrorMessage("Unable to open file: " + file_name.string());
+
+		std::vector<char> buffer(1 << 16);
+		while (fInput)
+		{
+			fInput.read(buffer.data(), buffer.size());
+			hash = HashBytes(buffer.data(), static_cast<size_t>(fInput.gcount()), hash);
+		}
+		return hash;
+	}
+
+	//!  Reuse of the interpreted kinetic scheme across runs
+	/*!
+		 When the kinetic scheme is given through @KineticsPreProcessor, the CHEMKIN files are
+		 interpreted and written (XML) in the output folder of the preprocessor. A stamp with the
+		 hash of the CHEMKIN input files is stored next to the XML files: if on the following runs
+		 the hash matches, the interpretation is skipped and the output folder is loaded as if it
+		 was given with @KineticsFolder.
+	*/
+	class KineticsPreProcessorCache
+	{
+	public:
+
+		KineticsPreProcessorCache(const boost::filesystem::path& output_folder, const std::vector<boost::filesystem::path>& input_files) :
+			output_folder_(output_folder),
+			hash_(HashBytes(0, 0))
+		{
+			for (unsigned int k = 0; k < input_files.size(); k++)
+			{
+				const std::string name = input_files[k].filename().string();
+				hash_ = HashBytes(name.data(), name.size(), hash_);
+				hash_ = HashFile(input_files[k], hash_);
+			}
+		}
+
+		//! True if the output folder contains the interpreted version of the current input files
+		bool IsValid() const
+		{
+			if (boost::filesystem::exists(output_folder_ / "kinetics.xml") == false)
+				return false;
+
+			std::ifstream fStamp((output_folder_ / StampFileName()).c_str(), std::ios::in);
+			if (!fStamp.is_open())
+				return false;
+
+			uint64_t hash;
+			fStamp >> std::hex >> hash;
+			return (!fStamp.fail() && hash == hash_);
+		}
+
+		//! To be called after a successful interpretation of the kinetic scheme
+		void Update() const
+		{
+			std::ofstream fStamp((output_folder_ / StampFileName()).c_str(), std::ios::out);
+			if (!fStamp.is_open())
+				OpenSMOKE::FatalErrorMessage("Unable to write the kinetics stamp in " + output_folder_.string());
+			fStamp << std::hex << hash_ << std::endl;
+		}
+
+		//! Folder to be loaded in place of @KineticsFolder
+		const boost::filesystem::path& KineticsFolder() const { return output_folder_; }
+
+	private:
+
+		static const char* StampFileName() { return "NetSMOKE.kinetics.hash"; }
+
+	private:
+
+		boost::filesystem::path output_folder_;
+		uint64_t hash_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_KINETICSPREPROCESSORCACHE_H */
@@ -0,0 +1,189 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+
+#ifndef NETSMOKE_MEASUREUNITS_H
+#define NETSMOKE_MEASUREUNITS_H
+
+#include <string>
+#include <stdint.h>
+#include "ReadErrors.h"
+
+namespace NetSMOKE
+{
+	enum Dimension
+	{
+		DIMENSION_TEMPERATURE,					// K
+		DIMENSION_PRESSURE,						// Pa
+		DIMENSION_TIME,							// s
+		DIMENSION_LENGTH,						// m
+		DIMENSION_VOLUME,						// m3
+		DIMENSION_DENSITY,						// kg/m3
+		DIMENSION_VOLUMETRIC_FLOW,				// m3/s
+		DIMENSION_THERMAL_CONDUCTANCE,			// W/K
+		DIMENSION_HEAT_TRANSFER_COEFFICIENT		// W/m2/K
+	};
+
+	//! Unit of measure: value [SI] = value [unit] * scale + offset
+	struct MeasureUnit
+	{
+		const char* token;
+		Dimension dimension;
+		double scale;
+		double offset;
+	};
+
+	//! Table of the units accepted by the grammars (to add a unit, add a line here)
+	constexpr MeasureUnit MeasureUnits[] =
+	{
+		{ "K",		DIMENSION_TEMPERATURE,	1.,				0. },
+		{ "C",		DIMENSION_TEMPERATURE,	1.,				273.15 },
+
+		{ "Pa",		DIMENSION_PRESSURE,		1.,				0. },
+		{ "kPa",	DIMENSION_PRESSURE,		1.e3,			0. },
+		{ "MPa",	DIMENSION_PRESSURE,		1.e6,			0. },
+		{ "bar",	DIMENSION_PRESSURE,		1.e5,			0. },
+		{ "atm",	DIMENSION_PRESSURE,		101325.,		0. },
+
+		{ "s",		DIMENSION_TIME,			1.,				0. },
+		{ "ms",		DIMENSION_TIME,			1.e-3,			0. },
+		{ "min",	DIMENSION_TIME,			60.,			0. },
+		{ "hr",		DIMENSION_TIME,			3600.,			0. },
+
+		{ "m",		DIMENSION_LENGTH,		1.,				0. },
+		{ "cm",		DIMENSION_LENGTH,		1.e-2,			0. },
+		{ "mm",		DIMENSION_LENGTH,		1.e-3,			0. },
+
+		{ "m3",		DIMENSION_VOLUME,		1.,				0. },
+		{ "cm3",	DIMENSION_VOLUME,		1.e-6,			0. },
+		{ "l",		DIMENSION_VOLUME,		1.e-3,			0. },
+		{ "L",		DIMENSION_VOLUME,		1.e-3,			0. },
+
+		{ "kg/m3",	DIMENSION_DENSITY,		1.,				0. },
+		{ "g/cm3",	DIMENSION_DENSITY,		1.e3,			0. },
+
+		{ "m3/s",	DIMENSION_VOLUMETRIC_FLOW,	1.,			0. },
+		{ "L/min",	DIMENSION_VOLUMETRIC_FLOW,	1.e-3/60.,	0. },
+		{ "l/min",	DIMENSION_VOLUMETRIC_FLOW,	1.e-3/60.,	0. },
+
+		{ "W/K",	DIMENSION_THERMAL_CONDUCTANCE,	1.,		0. },
+
+		{ "W/m2/K",	DIMENSION_HEAT_TRANSFER_COEFFICIENT,	1.,	0. }
+	};
+
+	constexpr unsigned int NumberOfMeasureUnits = sizeof(MeasureUnits) / sizeof(MeasureUnit);
+
+	//! FNV-1a hash of a unit token (usable at compile time)
+	constexpr uint32_t UnitTokenHash(const char* token, const uint32_t hash = 2166136261u)
+	{
+		return (*token == '\0') ? hash : UnitTokenHash(token + 1, (hash ^ static_cast<unsigned char>(*token)) * 16777619u);
+	}
+
+	constexpr bool UnitTokenEqual(const char* a, const char* b)
+	{
+		return (*a == *b) && (*a == '\0' || UnitTokenEqual(a + 1, b + 1));
+	}
+
+	//! Index of a unit of the given dimension in MeasureUnits (-1 if not available)
+	constexpr int MeasureUnitIndex(const char* token, const Dimension dimension, const unsigned int i = 0)
+	{
+		return (i == NumberOfMeasureUnits) ? -1 :
+				(MeasureUnits[i].dimension == dimension && UnitTokenEqual(MeasureUnits[i].token, token)) ? static_cast<int>(i) :
+				MeasureUnitIndex(token, dimension, i + 1);
+	}
+
+	//! Value expressed in the SI unit of its dimension
+	template<Dimension D>
+	struct Quantity
+	{
+		constexpr explicit Quantity(const double si_value) : value(si_value) {}
+		double value;
+	};
+
+	//! Conversion to SI of a value given in a unit known at compile time (i.e. ToSI<DIMENSION_PRESSURE>(1., "atm"))
+	template<Dimension D>
+	constexpr Quantity<D> ToSI(const double value, const char* token)
+	{
+		return Quantity<D>(value * MeasureUnits[MeasureUnitIndex(token, D)].scale + MeasureUnits[MeasureUnitIndex(token, D)].offset);
+	}
+
+	//! Interned tokens of the unit table: units are looked up by hash and the token is compared only on a match
+	class MeasureUnitTable
+	{
+	public:
+
+		static const MeasureUnitTable& Instance()
+		{
+			static const MeasureUnitTable table;
+			return table;
+		}
+
+		//! Index in MeasureUnits, -1 if the unit does not exist or has a different dimension
+		int Find(const std::string& token, const Dimension dimension) const
+		{
+			const uint32_t hash = UnitTokenHash(token.c_str());
+			for (unsigned int i = 0; i < NumberOfMeasureUnits; i++)
+				if (hash_[i] == hash && MeasureUnits[i].dimension == dimension && token == MeasureUnits[i].token)
+					return static_cast<int>(i);
+			return -1;
+		}
+
+		//! List of the units of a dimension, for the error messages
+		std::string Units(const Dimension dimension) const
+		{
+			std::string list;
+			for (unsigned int i = 0; i < NumberOfMeasureUnits; i++)
+				if (MeasureUnits[i].dimension == dimension)
+					list += (list.empty() ? "" : ", ") + std::string(MeasureUnits[i].token);
+			return list;
+		}
+
+	private:
+
+		MeasureUnitTable()
+		{
+			for (unsigned int i = 0; i < NumberOfMeasureUnits; i++)
+				hash_[i] = UnitTokenHash(MeasureUnits[i].token);
+		}
+
+		uint32_t hash_[NumberOfMeasureUnits];
+	};
+
+	//! Conversion to SI of a value read from a dictionary; unsupported units are a fatal error
+	template<Dimension D>
+	Quantity<D> ConvertMeasure(const double value, const std::string& units, const std::string& keyword)
+	{
+		const MeasureUnitTable& table = MeasureUnitTable::Instance();
+		const int i = table.Find(units, D);
+		if (i < 0)
+			ReadErrorMessage("Unknown units " + units + " for " + keyword + " (use " + table.Units(D) + ")");
+		return Quantity<D>(value * MeasureUnits[i].scale + MeasureUnits[i].offset);
+	}
+
+	//! Reads a measure from the dictionary and converts it to SI
+	template<Dimension D>
+	Quantity<D> ReadQuantity(OpenSMOKE::OpenSMOKE_Dictionary& dictionary, const std::string& keyword)
+	{
+		double value;
+		std::string units;
+		dictionary.ReadMeasure(keyword, value, units);
+		return ConvertMeasure<D>(value, units, keyword);
+	}
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_MEASUREUNITS_H */
@@ -0,0 +1,349 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_MIXERKERNEL_H
+#define NETSMOKE_MIXERKERNEL_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#if defined(__AVX2__) || defined(__AVX512F__)
+	#include <immintrin.h>
+#endif
+#include "NetworkTopology.h"
+#include "StreamStateArena.h"
+#include "NetworkTelemetry.h"
+
+namespace NetSMOKE
+{
+	//!  NASA 7-coefficient polynomials rearranged for SIMD evaluation
+	/*!
+		 For every species and temperature range the coefficients are pre-multiplied by R/MW
+		 (and by 1/k for the enthalpy), so that the mass specific enthalpy and heat capacity are
+		 h = b5 + T(b0 + T(b1 + T(b2 + T(b3 + T b4))))		[J/kg]
+		 cp = c0 + T(c1 + T(c2 + T(c3 + T c4)))				[J/kg/K]
+		 Coefficients are stored coefficient-major with the species padded as the rows of the
+		 StreamStateArena (padding species have zero coefficients).
+	*/
+	class MixerThermoTable
+	{
+	public:
+
+		static const unsigned int NumberOfEnthalpyCoefficients = 6;
+		static const unsigned int NumberOfCpCoefficients = 5;
+
+		MixerThermoTable() : number_of_species_(0), stride_(0) {}
+
+		void Setup(const unsigned int number_of_species, const unsigned int stride)
+		{
+			number_of_species_ = number_of_species;
+			stride_ = stride;
+			for (unsigned int r = 0; r < 2; r++)
+			{
+				h_[r].assign(NumberOfEnthalpyCoefficients * stride_, 0.);
+				cp_[r].assign(NumberOfCpCoefficients * stride_, 0.);
+			}
+			T_mid_.assign(stride_, 1000.);
+		}
+
+		//! a_low and a_high are the usual 7 NASA coefficients (dimensionless), MW in kg/kmol
+		void SetSpecies(const unsigned int i, const double MW, const double T_mid, const double* a_low, const double* a_high)
+		{
+			const double* a[2] = { a_low, a_high };
+			const double R = PhysicalConstants::R_J_kmol / MW;
+
+			T_mid_[i] = T_mid;
+			for (unsigned int r = 0; r < 2; r++)
+			{
+				for (unsigned int k = 0; k < 5; k++)
+				{
+					h_[r][k * stride_ + i] = R * a[r][k] / double(k + 1);
+					cp_[r][k * stride_ + i] = R * a[r][k];
+				}
+				h_[r][5 * stride_ + i] = R * a[r][5];
+			}
+		}
+
+		unsigned int NumberOfSpecies() const { return number_of_species_; }
+		unsigned int Stride() const { return stride_; }
+
+		//! Mass specific enthalpy [J/kg] and heat capacity [J/kg/K] of a mixture with mass fractions omega (aligned, padded)
+		void MixtureEnthalpyAndCp(const double T, const double* omega, double& h, double& cp) const
+		{
+#if defined(__AVX512F__)
+			MixtureEnthalpyAndCpAVX512(T, omega, h, cp);
+#elif defined(__AVX2__)
+			MixtureEnthalpyAndCpAVX2(T, omega, h, cp);
+#else
+			MixtureEnthalpyAndCpScalar(T, omega, h, cp);
+#endif
+		}
+
+		void MixtureEnthalpyAndCpScalar(const double T, const double* omega, double& h, double& cp) const
+		{
+			h = 0.;
+			cp = 0.;
+			for (unsigned int i = 0; i < stride_; i++)
+			{
+				const unsigned int r = (T > T_mid_[i]) ? 1 : 0;
+				const double* b = &h_[r][i];
+				const double* c = &cp_[r][i];
+				const unsigned int s = stride_;
+				const double hi = b[5 * s] + T * (b[0] + T * (b[s] + T * (b[2 * s] + T * (b[3 * s] + T * b[4 * s]))));
+				const double cpi = c[0] + T * (c[s] + T * (c[2 * s] + T * (c[3 * s] + T * c[4 * s])));
+				h += omega[i] * hi;
+				cp += omega[i] * cpi;
+			}
+		}
+
+#if defined(__AVX2__)
+		void MixtureEnthalpyAndCpAVX2(const double T, const double* omega, double& h, double& cp) const
+		{
+			const unsigned int s = stride_;
+			const __m256d vT = _mm256_set1_pd(T);
+			__m256d h_sum = _mm256_setzero_pd();
+			__m256d cp_sum = _mm256_setzero_pd();
+
+			for (unsigned int i = 0; i < s; i += 4)
+			{
+				const __m256d high = _mm256_cmp_pd(vT, _mm256_load_pd(&T_mid_[i]), _CMP_GT_OQ);
+
+				__m256d hi = Select4(high, &h_[0][4 * s + i], &h_[1][4 * s + i]);
+				for (int k = 3; k >= 0; k--)
+					hi = Fma4(hi, vT, Select4(high, &h_[0][k * s + i], &h_[1][k * s + i]));
+				hi = Fma4(hi, vT, Select4(high, &h_[0][5 * s + i], &h_[1][5 * s + i]));
+
+				__m256d cpi = Select4(high, &cp_[0][4 * s + i], &cp_[1][4 * s + i]);
+				for (int k = 3; k >= 0; k--)
+					cpi = Fma4(cpi, vT, Select4(high, &cp_[0][k * s + i], &cp_[1][k * s + i]));
+
+				const __m256d w = _mm256_load_pd(omega + i);
+				h_sum = Fma4(w, hi, h_sum);
+				cp_sum = Fma4(w, cpi, cp_sum);
+			}
+
+			h = HorizontalSum4(h_sum);
+			cp = HorizontalSum4(cp_sum);
+		}
+#endif
+
+#if defined(__AVX512F__)
+		void MixtureEnthalpyAndCpAVX512(const double T, const double* omega, double& h, double& cp) const
+		{
+			const unsigned int s = stride_;
+			const __m512d vT = _mm512_set1_pd(T);
+			__m512d h_sum = _mm512_setzero_pd();
+			__m512d cp_sum = _mm512_setzero_pd();
+
+			for (unsigned int i = 0; i < s; i += 8)
+			{
+				const __mmask8 high = _mm512_cmp_pd_mask(vT, _mm512_load_pd(&T_mid_[i]), _CMP_GT_OQ);
+
+				__m512d hi = Select8(high, &h_[0][4 * s + i], &h_[1][4 * s + i]);
+				for (int k = 3; k >= 0; k--)
+					hi = _mm512_fmadd_pd(hi, vT, Select8(high, &h_[0][k * s + i], &h_[1][k * s + i]));
+				hi = _mm512_fmadd_pd(hi, vT, Select8(high, &h_[0][5 * s + i], &h_[1][5 * s + i]));
+
+				__m512d cpi = Select8(high, &cp_[0][4 * s + i], &cp_[1][4 * s + i]);
+				for (int k = 3; k >= 0; k--)
+					cpi = _mm512_fmadd_pd(cpi, vT, Select8(high, &cp_[0][k * s + i], &cp_[1][k * s + i]));
+
+				const __m512d w = _mm512_load_pd(omega + i);
+				h_sum = _mm512_fmadd_pd(w, hi, h_sum);
+				cp_sum = _mm512_fmadd_pd(w, cpi, cp_sum);
+			}
+
+			h = HorizontalSum8(h_sum);
+			cp = HorizontalSum8(cp_sum);
+		}
+#endif
+
+	private:
+
+#if defined(__AVX2__)
+		static __m256d Select4(const __m256d mask, const double* low, const double* high)
+		{
+			return _mm256_blendv_pd(_mm256_load_pd(low), _mm256_load_pd(high), mask);
+		}
+
+		static __m256d Fma4(const __m256d a, const __m256d b, const __m256d c)
+		{
+	#if defined(__FMA__)
+			return _mm256_fmadd_pd(a, b, c);
+	#else
+			return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+	#endif
+		}
+
+		static double HorizontalSum4(const __m256d v)
+		{
+			const __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+			return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+		}
+#endif
+
+#if defined(__AVX512F__)
+		static __m512d Select8(const __mmask8 mask, const double* low, const double* high)
+		{
+			return _mm512_mask_blend_pd(mask, _mm512_load_pd(low), _mm512_load_pd(high));
+		}
+
+		static double HorizontalSum8(const __m512d v)
+		{
+			alignas(64) double lanes[8];
+			_mm512_store_pd(lanes, v);
+			return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+		}
+#endif
+
+	private:
+
+		unsigned int number_of_species_;
+		unsigned int stride_;
+
+		StreamStateArena::AlignedVector h_[2];
+		StreamStateArena::AlignedVector cp_[2];
+		StreamStateArena::AlignedVector T_mid_;
+	};
+
+	//!  Adiabatic mixer working directly on the rows of the StreamStateArena
+	/*!
+		 Outlet composition: mass-weighted sum of the inlet rows. Outlet temperature: Newton
+		 iterations on the enthalpy balance sum_j(m_j h(T_j,omega_j)) = m h(T,omega), starting
+		 from the mass-weighted inlet temperature. Outlet pressure: lowest inlet pressure.
+		 If the Newton iterations fail (non-positive cp, non-finite step or no convergence) the
+		 outlet is left at the mass-weighted inlet temperature and Solve returns false.
+		 The composition is accumulated in a per-thread scratch row and copied to the outlet at
+		 the end, since an inlet row can be a view of the outlet row itself (recycle loops).
+	*/
+	class MixerKernel
+	{
+	public:
+
+		MixerKernel(const NetworkTopology& topology, const MixerThermoTable& thermo) :
+			topology_(topology),
+			thermo_(thermo),
+			telemetry_(nullptr)
+		{
+		}
+
+		//! Telemetry receiving the statistics of every mixer (null: none)
+		void SetTelemetry(NetworkTelemetry* telemetry) { telemetry_ = telemetry; }
+
+		//! Solves all the mixers among the given units (i.e. the units of a block), returns false if any failed
+		bool Solve(const std::vector<unsigned int>& units, StreamStateArena& arena) const
+		{
+			bool success = true;
+			for (unsigned int k = 0; k < units.size(); k++)
+				if (topology_.Type()[units[k]] == UNIT_MIXER)
+					success = Solve(units[k], arena) && success;
+			return success;
+		}
+
+		//! Returns false if the outlet temperature did not converge
+		bool Solve(const unsigned int unit, StreamStateArena& arena) const
+		{
+			NetworkTelemetry::ScopedUnitTimer timer(telemetry_, unit);
+			const unsigned int first = topology_.InletPtr()[unit];
+			const unsigned int last = topology_.InletPtr()[unit + 1];
+			const unsigned int outlet = topology_.OutletStreams()[topology_.OutletPtr()[unit]];
+			const unsigned int stride = arena.Stride();
+
+			static thread_local StreamStateArena::AlignedVector scratch;
+			scratch.assign(stride, 0.);
+			double* omega = &scratch[0];
+
+			double m = 0.;
+			double H = 0.;
+			double T = 0.;
+			double P = arena.Pressure(topology_.InletStreams()[first]);
+
+			for (unsigned int j = first; j < last; j++)
+			{
+				const unsigned int s = topology_.InletStreams()[j];
+				const double mj = arena.MassFlow(s);
+				const double* omega_j = arena.MassFractions(s);
+
+				double hj, cpj;
+				thermo_.MixtureEnthalpyAndCp(arena.Temperature(s), omega_j, hj, cpj);
+
+				m += mj;
+				H += mj * hj;
+				T += mj * arena.Temperature(s);
+				P = std::min(P, arena.Pressure(s));
+
+				for (unsigned int i = 0; i < stride; i++)
+					omega[i] += mj * omega_j[i];
+			}
+
+			if (m <= 0.)
+				OpenSMOKE::FatalErrorMessage("Mixer " + topology_.UnitNames()[unit] + ": the total inlet mass flow rate is not positive");
+
+			const double one_over_m = 1. / m;
+			for (unsigned int i = 0; i < stride; i++)
+				omega[i] *= one_over_m;
+			H *= one_over_m;
+			T *= one_over_m;
+
+			const double T_guess = T;
+			unsigned int iterations = 0;
+			bool converged = false;
+			for (unsigned int k = 0; k < 50; k++)
+			{
+				double h, cp;
+				thermo_.MixtureEnthalpyAndCp(T, omega, h, cp);
+				iterations++;
+				if (!(cp > 0.))
+					break;
+				const double dT = (H - h) / cp;
+				if (!std::isfinite(dT))
+					break;
+				T += dT;
+				if (std::fabs(dT) < 1.e-8 * T)
+				{
+					converged = (T > 0.);
+					break;
+				}
+			}
+			if (converged == false)
+				T = T_guess;
+
+			if (telemetry_ != nullptr)
+			{
+				UnitCounters& counters = telemetry_->Local(unit);
+				counters.newton_iterations += iterations;
+				if (converged == false)
+					counters.failures++;
+			}
+
+			std::copy(omega, omega + stride, arena.MassFractions(outlet));
+			arena.Temperature(outlet) = T;
+			arena.Pressure(outlet) = P;
+			arena.MassFlow(outlet) = m;
+			return converged;
+		}
+
+	private:
+
+		const NetworkTopology& topology_;
+		const MixerThermoTable& thermo_;
+		NetworkTelemetry* telemetry_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_MIXERKERNEL_H */
@@ -0,0 +1,622 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+
+#ifndef NETSMOKE_NETWORKBENCHMARK_H
+#define NETSMOKE_NETWORKBENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <utility>
+#include "boost/filesystem.hpp"
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+#include "NetworkTopology.h"
+#include "NetworkSolveOrder.h"
+#include "TearStreams.h"
+#include "StreamStateArena.h"
+
+namespace NetSMOKE
+{
+	enum SyntheticShape { SHAPE_PSR_CHAIN, SHAPE_PFR_TRAIN, SHAPE_RECYCLE_LOOPS, SHAPE_PARALLEL_FAN, SHAPE_RANDOM_SPARSE };
+
+	inline std::string SyntheticShapeName(const SyntheticShape shape)
+	{
+		switch (shape)
+		{
+			case SHAPE_PSR_CHAIN:		return "PSRChain";
+			case SHAPE_PFR_TRAIN:		return "PFRTrain";
+			case SHAPE_RECYCLE_LOOPS:	return "RecycleLoops";
+			case SHAPE_PARALLEL_FAN:	return "ParallelFan";
+			case SHAPE_RANDOM_SPARSE:	return "RandomSparse";
+		}
+		return "";
+	}
+
+	//! Size and shape of a synthetic network
+	struct SyntheticNetworkOptions
+	{
+		SyntheticNetworkOptions() :
+			shape(SHAPE_PSR_CHAIN),
+			number_of_reactors(100),
+			loop_length(4),
+			recycle_ratio(0.5),
+			average_degree(6.),
+			backflow_fraction(0.3),
+			seed(1)
+		{
+		}
+
+		SyntheticShape shape;
+		unsigned int number_of_reactors;
+		unsigned int loop_length;			// RecycleLoops: reactors between a mixer and its splitter
+		double recycle_ratio;				// RecycleLoops: fraction of the splitter inlet sent back
+		double average_degree;				// RandomSparse: average number of outlet streams per reactor
+		double backflow_fraction;			// RandomSparse: fraction of the streams going upstream (recycles)
+		unsigned int seed;
+	};
+
+	//!  Synthetic network of parameterized size and shape, used for benchmarking
+	/*!
+		 PSRChain, PFRTrain, RecycleLoops and ParallelFan are lists of units (as read from the
+		 input dictionaries); RandomSparse is a single block of PSRs mimicking the output of a
+		 CFD clustering (a 3D-like neighbourhood plus random long-range and upstream streams).
+		 The network is fed by stream 0 with a mass flow rate of 1 kg/s; mass_flows contains the
+		 flow rates of the outlet streams of the splitters (by stream ID).
+	*/
+	struct SyntheticNetwork
+	{
+		std::string name;
+		std::vector<NetSMOKE::UnitInfo> units;
+		std::vector<NetSMOKE::ReactorBlock> blocks;
+		std::vector< std::pair<int, double> > mass_flows;
+
+		//! Compiles the network and sets the flow rates of the splitters
+		void Compile(NetworkTopology& topology) const
+		{
+			topology.Compile(units, blocks);
+			for (unsigned int j = 0; j < mass_flows.size(); j++)
+				topology.SetStreamMassFlow(topology.IndexOfStream(mass_flows[j].first), mass_flows[j].second);
+		}
+	};
+
+	inline NetSMOKE::UnitInfo SyntheticReactor(const std::string& name, const std::string& tag, const int inlet, const int outlet)
+	{
+		NetSMOKE::UnitInfo unit;
+		unit.name = name;
+		unit.tag = tag;
+		unit.energy = "Isothermal";
+		unit.temperature = 1200.;
+		unit.pressure = 101325.;
+		unit.UA = 0.;
+		unit.residence_time = (tag == "PSR") ? 0.01 : -1;
+		unit.volume = -1;
+		unit.diameter = (tag == "PFR") ? 0.02 : -1;
+		unit.length = (tag == "PFR") ? 0.1 : -1;
+		unit.inlets.push_back(inlet);
+		unit.outlets.push_back(outlet);
+		return unit;
+	}
+
+	inline NetSMOKE::UnitInfo SyntheticConnector(const std::string& name, const std::string& tag, const std::vector<int>& inlets, const std::vector<int>& outlets)
+	{
+		NetSMOKE::UnitInfo unit;
+		unit.name = name;
+		unit.tag = tag;
+		unit.energy = "Adiabatic";
+		unit.temperature = -1;
+		unit.pressure = 101325.;
+		unit.UA = 0.;
+		unit.residence_time = -1;
+		unit.volume = -1;
+		unit.diameter = -1;
+		unit.length = -1;
+		unit.inlets = inlets;
+		unit.outlets = outlets;
+		return unit;
+	}
+
+	inline void GenerateSyntheticNetwork(const SyntheticNetworkOptions& options, SyntheticNetwork& network)
+	{
+		const unsigned int n = std::max(options.number_of_reactors, 1u);
+
+		network = SyntheticNetwork();
+		network.name = SyntheticShapeName(options.shape) + "_" + std::to_string(n);
+
+		if (options.shape == SHAPE_PSR_CHAIN || options.shape == SHAPE_PFR_TRAIN)
+		{
+			const std::string tag = (options.shape == SHAPE_PSR_CHAIN) ? "PSR" : "PFR";
+			for (unsigned int i = 0; i < n; i++)
+				network.units.push_back(SyntheticReactor("R" + std::to_string(i), tag, i, i + 1));
+		}
+		else if (options.shape == SHAPE_RECYCLE_LOOPS)
+		{
+			// Loops in series: Mixer(feed, recycle) -> loop_length PSRs -> Splitter(forward, recycle)
+			const unsigned int length = std::max(options.loop_length, 1u);
+			const unsigned int loops = (n + length - 1) / length;
+			int id = 0;
+			int feed = id++;
+			double flow = 1.;
+			for (unsigned int l = 0; l < loops; l++)
+			{
+				const std::string suffix = std::to_string(l);
+				const int recycle = id++;
+				int stream = id++;
+				network.units.push_back(SyntheticConnector("M" + suffix, "Mixer", std::vector<int>{ feed, recycle }, std::vector<int>{ stream }));
+
+				for (unsigned int i = 0; i < length && l * length + i < n; i++, id++)
+				{
+					network.units.push_back(SyntheticReactor("R" + std::to_string(l * length + i), "PSR", stream, id));
+					stream = id;
+				}
+
+				feed = id++;
+				network.units.push_back(SyntheticConnector("S" + suffix, "Splitter", std::vector<int>{ stream }, std::vector<int>{ feed, recycle }));
+
+				// The loop processes flow/(1-r), of which flow leaves forward
+				const double r = std::min(std::max(options.recycle_ratio, 0.), 0.99);
+				network.mass_flows.push_back(std::make_pair(feed, flow));
+				network.mass_flows.push_back(std::make_pair(recycle, flow * r / (1. - r)));
+			}
+		}
+		else if (options.shape == SHAPE_PARALLEL_FAN)
+		{
+			std::vector<int> branches(n), products(n);
+			for (unsigned int i = 0; i < n; i++)
+			{
+				branches[i] = 1 + 2 * i;
+				products[i] = 2 + 2 * i;
+				network.units.push_back(SyntheticReactor("R" + std::to_string(i), "PSR", branches[i], products[i]));
+				network.mass_flows.push_back(std::make_pair(branches[i], 1. / n));
+			}
+			network.units.push_back(SyntheticConnector("S0", "Splitter", std::vector<int>{ 0 }, branches));
+			network.units.push_back(SyntheticConnector("M0", "Mixer", products, std::vector<int>{ 2 * static_cast<int>(n) + 1 }));
+		}
+		else if (options.shape == SHAPE_RANDOM_SPARSE)
+		{
+			std::mt19937 generator(options.seed);
+			std::uniform_real_distribution<double> uniform(0., 1.);
+
+			NetSMOKE::ReactorBlock block;
+			block.name = "B";
+			block.tag = "PSR";
+			block.energy = "Isothermal";
+			block.volume.assign(n, 1.e-6);
+			block.temperature.resize(n);
+			block.pressure.assign(n, 101325.);
+			for (unsigned int i = 0; i < n; i++)
+				block.temperature[i] = 1000. + 800. * uniform(generator);
+
+			// Reactors are numbered along a cube: neighbours at distance 1, side and side^2
+			unsigned int side = 1;
+			while (side * side * side < n)
+				side++;
+			const unsigned int offsets[3] = { 1, side, side * side };
+
+			std::vector<int> from, to;
+			std::vector<double> flows;
+			for (unsigned int i = 0; i < n; i++)
+			{
+				// Forward stream to the next reactor keeps everything reachable from the inlet
+				if (i + 1 < n)
+				{
+					from.push_back(i);
+					to.push_back(i + 1);
+				}
+
+				const double extra = std::max(options.average_degree - 1., 0.);
+				const unsigned int m = static_cast<unsigned int>(extra) + (uniform(generator) < extra - std::floor(extra) ? 1 : 0);
+				for (unsigned int k = 0; k < m; k++)
+				{
+					const bool backward = uniform(generator) < options.backflow_fraction;
+					const bool local = uniform(generator) < 0.8;
+					const unsigned int distance = local ? offsets[generator() % 3] : 1 + generator() % n;
+					if (backward && i >= distance)
+					{
+						from.push_back(i);
+						to.push_back(i - distance);
+					}
+					else if (backward == false && i + distance < n)
+					{
+						from.push_back(i);
+						to.push_back(i + distance);
+					}
+				}
+			}
+
+			// Indicative flow rates: the outlet of every reactor is split evenly among its streams
+			const int first_id = 2;
+			block.flow_ids.resize(from.size());
+			block.flow_rates.resize(from.size());
+			std::vector<unsigned int> degree(n, 0);
+			for (unsigned int k = 0; k < from.size(); k++)
+				degree[from[k]]++;
+			for (unsigned int k = 0; k < from.size(); k++)
+			{
+				block.flow_ids[k] = first_id + static_cast<int>(k);
+				block.flow_rates[k] = 1. / (degree[from[k]] + 1.);
+			}
+
+			// Inlet 0 to reactor 0, outlet 1 from the last reactor
+			std::vector<int> inlet_reactor(1, 0), outlet_reactor(1, n - 1);
+			block.inlet_ptr.assign(n + 1, 0);
+			block.outlet_ptr.assign(n + 1, 0);
+			block.inlet_ptr[1]++;
+			block.outlet_ptr[n]++;
+			for (unsigned int k = 0; k < from.size(); k++)
+			{
+				block.outlet_ptr[from[k] + 1]++;
+				block.inlet_ptr[to[k] + 1]++;
+			}
+			for (unsigned int i = 0; i < n; i++)
+			{
+				block.inlet_ptr[i + 1] += block.inlet_ptr[i];
+				block.outlet_ptr[i + 1] += block.outlet_ptr[i];
+			}
+			block.inlet_ids.resize(block.inlet_ptr[n]);
+			block.outlet_ids.resize(block.outlet_ptr[n]);
+			std::vector<unsigned int> inlet_position(block.inlet_ptr.begin(), block.inlet_ptr.end() - 1);
+			std::vector<unsigned int> outlet_position(block.outlet_ptr.begin(), block.outlet_ptr.end() - 1);
+			block.inlet_ids[inlet_position[0]++] = 0;
+			block.outlet_ids[outlet_position[n - 1]++] = 1;
+			for (unsigned int k = 0; k < from.size(); k++)
+			{
+				block.outlet_ids[outlet_position[from[k]]++] = block.flow_ids[k];
+				block.inlet_ids[inlet_position[to[k]]++] = block.flow_ids[k];
+			}
+
+			network.blocks.push_back(block);
+		}
+	}
+
+	//! Writes the synthetic network as NetSMOKE input (input.dic, plus the files of the reactor blocks)
+	/*!
+		 Only reactors and reactor blocks can be written, since they are the only units
+		 whose grammar declares the streams: the networks with mixers and splitters
+		 (RecycleLoops, ParallelFan) are benchmarked starting from the compiled units.
+		 The NetSMOKE dictionary refers (@Inlets, @Reactors, @ReactorBlocks) to the list
+		 dictionaries Inlets, Reactors and ReactorBlocks, which name the dictionaries of the
+		 single units with the same keyword (i.e. @Reactors R0 R1 R2;). The network inlets
+		 (streams entering a unit and leaving none) are fed with the given mass fractions, at
+		 the temperature and pressure of the unit they enter; the kinetics_folder must contain
+		 a mechanism with the species of inlet_mass_fractions.
+	*/
+	inline void WriteSyntheticInput(const SyntheticNetwork& network, const boost::filesystem::path& folder,
+									const boost::filesystem::path& kinetics_folder,
+									const std::vector< std::pair<std::string, double> >& inlet_mass_fractions)
+	{
+		for (unsigned int k = 0; k < network.units.size(); k++)
+			if (network.units[k].tag != "PSR" && network.units[k].tag != "PFR")
+				OpenSMOKE::FatalErrorMessage("Synthetic network " + network.name + ": only reactors and reactor blocks can be written as input");
+
+		if (!boost::filesystem::exists(folder))
+			boost::filesystem::create_directories(folder);
+
+		std::ofstream fOutput((folder / "input.dic").c_str(), std::ios::out);
+		fOutput.setf(std::ios::scientific);
+		fOutput.precision(9);
+
+		// Network inlets: streams entering a unit (reactor or reactor block) and leaving none
+		std::vector<int> inlet_ids;
+		std::vector<double> inlet_temperature, inlet_pressure;
+		{
+			std::vector<int> produced;
+			for (unsigned int k = 0; k < network.units.size(); k++)
+				produced.insert(produced.end(), network.units[k].outlets.begin(), network.units[k].outlets.end());
+			for (unsigned int b = 0; b < network.blocks.size(); b++)
+				produced.insert(produced.end(), network.blocks[b].outlet_ids.begin(), network.blocks[b].outlet_ids.end());
+			std::sort(produced.begin(), produced.end());
+
+			for (unsigned int k = 0; k < network.units.size(); k++)
+				for (unsigned int j = 0; j < network.units[k].inlets.size(); j++)
+					if (!std::binary_search(produced.begin(), produced.end(), network.units[k].inlets[j]))
+					{
+						inlet_ids.push_back(network.units[k].inlets[j]);
+						inlet_temperature.push_back(network.units[k].temperature);
+						inlet_pressure.push_back(network.units[k].pressure);
+					}
+			for (unsigned int b = 0; b < network.blocks.size(); b++)
+			{
+				const NetSMOKE::ReactorBlock& block = network.blocks[b];
+				for (unsigned int i = 0; i < block.NumberOfReactors(); i++)
+					for (unsigned int j = block.inlet_ptr[i]; j < block.inlet_ptr[i + 1]; j++)
+						if (!std::binary_search(produced.begin(), produced.end(), block.inlet_ids[j]))
+						{
+							inlet_ids.push_back(block.inlet_ids[j]);
+							inlet_temperature.push_back(block.temperature[i]);
+							inlet_pressure.push_back(block.pressure[i]);
+						}
+			}
+		}
+		if (inlet_ids.empty() == true)
+			OpenSMOKE::FatalErrorMessage("Synthetic network " + network.name + ": no inlet streams");
+
+		fOutput << "Dictionary NetSMOKE" << std::endl;
+		fOutput << "{" << std::endl;
+		fOutput << "\t@KineticsFolder " << kinetics_folder.string() << ";" << std::endl;
+		fOutput << "\t@Inlets Inlets;" << std::endl;
+		fOutput << "\t@Reactors Reactors;" << std::endl;
+		if (network.blocks.empty() == false)
+			fOutput << "\t@ReactorBlocks ReactorBlocks;" << std::endl;
+		fOutput << "}" << std::endl;
+
+		fOutput << std::endl;
+		fOutput << "Dictionary Inlets" << std::endl;
+		fOutput << "{" << std::endl;
+		fOutput << "\t@Inlets";
+		for (unsigned int j = 0; j < inlet_ids.size(); j++)
+			fOutput << " Inlet" << inlet_ids[j];
+		fOutput << ";" << std::endl;
+		fOutput << "}" << std::endl;
+
+		fOutput << std::endl;
+		fOutput << "Dictionary Reactors" << std::endl;
+		fOutput << "{" << std::endl;
+		fOutput << "\t@Reactors";
+		for (unsigned int k = 0; k < network.units.size(); k++)
+			fOutput << " " << network.units[k].name;
+		fOutput << ";" << std::endl;
+		fOutput << "}" << std::endl;
+
+		if (network.blocks.empty() == false)
+		{
+			fOutput << std::endl;
+			fOutput << "Dictionary ReactorBlocks" << std::endl;
+			fOutput << "{" << std::endl;
+			fOutput << "\t@ReactorBlocks";
+			for (unsigned int b = 0; b < network.blocks.size(); b++)
+				fOutput << " " << network.blocks[b].name;
+			fOutput << ";" << std::endl;
+			fOutput << "}" << std::endl;
+		}
+
+		for (unsigned int j = 0; j < inlet_ids.size(); j++)
+		{
+			// The network is fed with 1 kg/s, unless the flow rate of the stream is given
+			double mass_flow = 1.;
+			for (unsigned int k = 0; k < network.mass_flows.size(); k++)
+				if (network.mass_flows[k].first == inlet_ids[j])
+					mass_flow = network.mass_flows[k].second;
+
+			fOutput << std::endl;
+			fOutput << "Dictionary Inlet" << inlet_ids[j] << std::endl;
+			fOutput << "{" << std::endl;
+			fOutput << "\t@Stream " << inlet_ids[j] << ";" << std::endl;
+			fOutput << "\t@MassFlowRate " << mass_flow << " kg/s;" << std::endl;
+			fOutput << "\t@Temperature " << inlet_temperature[j] << " K;" << std::endl;
+			fOutput << "\t@Pressure " << inlet_pressure[j] << " Pa;" << std::endl;
+			fOutput << "\t@MassFractions";
+			for (unsigned int i = 0; i < inlet_mass_fractions.size(); i++)
+				fOutput << " " << inlet_mass_fractions[i].first << " " << inlet_mass_fractions[i].second;
+			fOutput << ";" << std::endl;
+			fOutput << "}" << std::endl;
+		}
+
+		for (unsigned int k = 0; k < network.units.size(); k++)
+		{
+			const NetSMOKE::UnitInfo& unit = network.units[k];
+			fOutput << std::endl;
+			fOutput << "Dictionary " << unit.name << std::endl;
+			fOutput << "{" << std::endl;
+			fOutput << "\t@Reactor " << unit.name << ";" << std::endl;
+			fOutput << "\tType " << unit.tag << ";" << std::endl;
+			fOutput << "\tPhase Gas;" << std::endl;
+			fOutput << "\tEnergy " << unit.energy << ";" << std::endl;
+			fOutput << "\tTemperature " << unit.temperature << " K;" << std::endl;
+			fOutput << "\tPressure " << unit.pressure << " Pa;" << std::endl;
+			if (unit.tag == "PSR")
+				fOutput << "\tResidenceTime " << unit.residence_time << " s;" << std::endl;
+			else
+			{
+				fOutput << "\tDiameter " << unit.diameter << " m;" << std::endl;
+				fOutput << "\tLength " << unit.length << " m;" << std::endl;
+			}
+			fOutput << "\tInletStream " << unit.inlets[0] << ";" << std::endl;
+			fOutput << "\tOutletStream " << unit.outlets[0] << ";" << std::endl;
+			fOutput << "}" << std::endl;
+		}
+
+		for (unsigned int b = 0; b < network.blocks.size(); b++)
+		{
+			const NetSMOKE::ReactorBlock& block = network.blocks[b];
+			const std::string units_file = block.name + ".units.txt";
+			const std::string flows_file = block.name + ".flows.txt";
+
+			// Inlets and outlets of the block are the streams which are not internal flows
+			std::vector<int> inlet_streams, inlet_reactors, outlet_streams, outlet_reactors;
+			std::vector<int> from(block.flow_ids.size(), -1), to(block.flow_ids.size(), -1);
+			const int first_id = block.flow_ids.empty() ? 0 : block.flow_ids[0];
+			for (unsigned int i = 0; i < block.NumberOfReactors(); i++)
+			{
+				for (unsigned int j = block.inlet_ptr[i]; j < block.inlet_ptr[i + 1]; j++)
+				{
+					const int k = block.inlet_ids[j] - first_id;
+					if (k >= 0 && k < static_cast<int>(to.size()))	to[k] = i;
+					else { inlet_streams.push_back(block.inlet_ids[j]); inlet_reactors.push_back(i); }
+				}
+				for (unsigned int j = block.outlet_ptr[i]; j < block.outlet_ptr[i + 1]; j++)
+				{
+					const int k = block.outlet_ids[j] - first_id;
+					if (k >= 0 && k < static_cast<int>(from.size()))	from[k] = i;
+					else { outlet_streams.push_back(block.outlet_ids[j]); outlet_reactors.push_back(i); }
+				}
+			}
+
+			{
+				std::ofstream fUnits((folder / units_file).c_str(), std::ios::out);
+				fUnits.setf(std::ios::scientific);
+				fUnits.precision(9);
+				for (unsigned int i = 0; i < block.NumberOfReactors(); i++)
+					fUnits << block.volume[i] << " " << block.temperature[i] << " " << block.pressure[i] << "\n";
+			}
+			{
+				std::ofstream fFlows((folder / flows_file).c_str(), std::ios::out);
+				fFlows.setf(std::ios::scientific);
+				fFlows.precision(9);
+				for (unsigned int k = 0; k < block.flow_ids.size(); k++)
+					fFlows << from[k] << " " << to[k] << " " << block.flow_rates[k] << "\n";
+			}
+
+			fOutput << std::endl;
+			fOutput << "Dictionary " << block.name << std::endl;
+			fOutput << "{" << std::endl;
+			fOutput << "\t@ReactorBlock " << block.name << ";" << std::endl;
+			fOutput << "\tType " << block.tag << ";" << std::endl;
+			fOutput << "\tEnergy " << block.energy << ";" << std::endl;
+			fOutput << "\tUnitsFile " << units_file << ";" << std::endl;
+			fOutput << "\tFlowsFile " << flows_file << ";" << std::endl;
+			fOutput << "\tFirstStreamID " << first_id << ";" << std::endl;
+			fOutput << "\tInletStreams";
+			for (unsigned int j = 0; j < inlet_streams.size(); j++)	fOutput << " " << inlet_streams[j];
+			fOutput << ";" << std::endl;
+			fOutput << "\tInletReactors";
+			for (unsigned int j = 0; j < inlet_reactors.size(); j++)	fOutput << " " << inlet_reactors[j];
+			fOutput << ";" << std::endl;
+			fOutput << "\tOutletStreams";
+			for (unsigned int j = 0; j < outlet_streams.size(); j++)	fOutput << " " << outlet_streams[j];
+			fOutput << ";" << std::endl;
+			fOutput << "\tOutletReactors";
+			for (unsigned int j = 0; j < outlet_reactors.size(); j++)	fOutput << " " << outlet_reactors[j];
+			fOutput << ";" << std::endl;
+			fOutput << "}" << std::endl;
+		}
+	}
+
+	//! Peak resident memory of the process [MB] (0 if not available)
+	inline double PeakResidentMemory()
+	{
+#if defined(_WIN32)
+		return 0.;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0.;
+	#if defined(__APPLE__)
+		return usage.ru_maxrss / 1048576.;		// bytes
+	#else
+		return usage.ru_maxrss / 1024.;			// kB
+	#endif
+#endif
+	}
+
+	//! Wall time [s] of a call
+	template<typename Function>
+	double MeasureWallTime(Function function)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//! Results of the benchmark of a single network
+	struct NetworkBenchmarkResult
+	{
+		NetworkBenchmarkResult() :
+			units(0), streams(0), blocks(0), tears(0), iterations(0),
+			parse_time(0.), compile_time(0.), analysis_time(0.), arena_time(0.), solve_time(0.), peak_memory(0.)
+		{
+		}
+
+		std::string name;
+		unsigned int units;
+		unsigned int streams;
+		unsigned int blocks;
+		unsigned int tears;
+		unsigned int iterations;
+
+		double parse_time;				// [s]
+		double compile_time;			// [s] topology
+		double analysis_time;			// [s] solve order and tear streams
+		double arena_time;				// [s] allocation of the stream states
+		double solve_time;				// [s]
+		double peak_memory;				// [MB]
+
+		double TimePerIteration() const { return iterations > 0 ? solve_time / iterations : 0.; }
+
+		static void WriteCSVHeader(std::ostream& out)
+		{
+			out << "Network,Units,Streams,Blocks,Tears,ParseTime[s],CompileTime[s],AnalysisTime[s],ArenaTime[s],";
+			out << "SolveTime[s],Iterations,TimePerIteration[s],PeakMemory[MB]" << std::endl;
+		}
+
+		void WriteCSV(std::ostream& out) const
+		{
+			out << name << "," << units << "," << streams << "," << blocks << "," << tears << ",";
+			out << parse_time << "," << compile_time << "," << analysis_time << "," << arena_time << ",";
+			out << solve_time << "," << iterations << "," << TimePerIteration() << "," << peak_memory << std::endl;
+		}
+	};
+
+	//!  Benchmark of the setup and solution of a network
+	/*!
+		 Compiles the network (best of repetitions), analyses it, allocates the stream states
+		 and calls the Iteration (i.e. one sweep of the solver over the solve order)
+			bool operator()(const NetworkTopology&, const NetworkSolveOrder&, const TearStreams&, StreamStateArena&)
+		 until it returns true (converged) or max_iterations are done.
+		 The parse time is measured by the caller (i.e. with MeasureWallTime around the reading
+		 of the input written by WriteSyntheticInput), since it depends on the dictionary manager.
+	*/
+	template<typename Iteration>
+	void RunNetworkBenchmark(	const SyntheticNetwork& network, const unsigned int number_of_species, Iteration& iteration,
+								const unsigned int max_iterations, const unsigned int repetitions, NetworkBenchmarkResult& result)
+	{
+		NetworkTopology topology;
+		NetworkSolveOrder order;
+		TearStreams tears;
+		StreamStateArena arena;
+
+		result.name = network.name;
+		result.compile_time = result.analysis_time = result.arena_time = -1.;
+		for (unsigned int r = 0; r < std::max(repetitions, 1u); r++)
+		{
+			const double compile_time = MeasureWallTime([&]() { network.Compile(topology); });
+			const double analysis_time = MeasureWallTime([&]() { order.Analyze(topology); tears.Select(topology, order); });
+			const double arena_time = MeasureWallTime([&]() { arena.Setup(topology, number_of_species); });
+
+			if (r == 0 || compile_time < result.compile_time)		result.compile_time = compile_time;
+			if (r == 0 || analysis_time < result.analysis_time)		result.analysis_time = analysis_time;
+			if (r == 0 || arena_time < result.arena_time)			result.arena_time = arena_time;
+		}
+
+		result.units = topology.NumberOfUnits();
+		result.streams = topology.NumberOfStreams();
+		result.blocks = order.NumberOfBlocks();
+		result.tears = tears.NumberOfTears();
+
+		result.iterations = 0;
+		result.solve_time = MeasureWallTime([&]()
+		{
+			while (result.iterations < max_iterations)
+			{
+				result.iterations++;
+				if (iteration(topology, order, tears, arena) == true)
+					break;
+			}
+		});
+
+		result.peak_memory = PeakResidentMemory();
+	}
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKBENCHMARK_H */
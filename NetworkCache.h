@@ -0,0 +1,385 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKCACHE_H
+#define NETSMOKE_NETWORKCACHE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+#include "boost/filesystem.hpp"
+#include "boost/iostreams/device/mapped_file.hpp"
+#include "NetworkTopology.h"
+
+namespace NetSMOKE
+{
+	//! 64-bit FNV-1a hash
+	inline uint64_t HashBytes(const char* data, const size_t size, uint64_t hash = 14695981039346656037ULL)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= static_cast<unsigned char>(data[i]);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// Native-endian binary I/O of scalars and arrays (arrays are preceded by their length)
+	template<typename T>
+	inline void WriteBinaryScalar(std::ofstream& fOutput, const T& value)
+	{
+		fOutput.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	inline void WriteBinaryArray(std::ofstream& fOutput, const std::vector<T>& values)
+	{
+		const uint64_t n = values.size();
+		WriteBinaryScalar(fOutput, n);
+		if (n > 0)
+			fOutput.write(reinterpret_cast<const char*>(values.data()), n * sizeof(T));
+	}
+
+	template<typename T>
+	inline bool ReadBinaryScalar(const char*& data, const char* end, T& value)
+	{
+		if (static_cast<size_t>(end - data) < sizeof(T))
+			return false;
+		std::memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+		return true;
+	}
+
+	template<typename T>
+	inline bool ReadBinaryArray(const char*& data, const char* end, std::vector<T>& values)
+	{
+		uint64_t n;
+		if (ReadBinaryScalar(data, end, n) == false || static_cast<uint64_t>(end - data) / sizeof(T) < n)
+			return false;
+		values.resize(static_cast<size_t>(n));
+		if (n > 0)
+			std::memcpy(values.data(), data, static_cast<size_t>(n) * sizeof(T));
+		data += n * sizeof(T);
+		return true;
+	}
+
+	//! True if ptr is a valid CSR pointer array: rows+1 non-decreasing entries from 0 to number_of_entries
+	template<typename T>
+	inline bool IsValidPointerArray(const std::vector<T>& ptr, const size_t rows, const size_t number_of_entries)
+	{
+		if (ptr.size() != rows + 1 || ptr[0] != 0 || ptr[rows] != number_of_entries)
+			return false;
+		for (size_t k = 0; k < rows; k++)
+			if (ptr[k] > ptr[k + 1])
+				return false;
+		return true;
+	}
+
+	//! True if all the values are in [lower, upper)
+	template<typename T>
+	inline bool AreInRange(const std::vector<T>& values, const T lower, const T upper)
+	{
+		for (size_t k = 0; k < values.size(); k++)
+			if (values[k] < lower || values[k] >= upper)
+				return false;
+		return true;
+	}
+
+	//! Names as offsets + characters
+	inline void WriteBinaryStrings(std::ofstream& fOutput, const std::vector<std::string>& strings)
+	{
+		std::vector<uint32_t> offsets(1, 0);
+		std::string characters;
+		for (unsigned int k = 0; k < strings.size(); k++)
+		{
+			characters += strings[k];
+			offsets.push_back(static_cast<uint32_t>(characters.size()));
+		}
+		WriteBinaryArray(fOutput, offsets);
+		WriteBinaryArray(fOutput, std::vector<char>(characters.begin(), characters.end()));
+	}
+
+	inline bool ReadBinaryStrings(const char*& data, const char* end, std::vector<std::string>& strings)
+	{
+		std::vector<uint32_t> offsets;
+		std::vector<char> characters;
+		if (ReadBinaryArray(data, end, offsets) == false || ReadBinaryArray(data, end, characters) == false)
+			return false;
+		if (offsets.empty() == true || IsValidPointerArray(offsets, offsets.size() - 1, characters.size()) == false)
+			return false;
+
+		strings.resize(offsets.size() - 1);
+		for (unsigned int k = 0; k + 1 < offsets.size(); k++)
+			strings[k].assign(characters.begin() + offsets[k], characters.begin() + offsets[k + 1]);
+		return true;
+	}
+
+	//!  Adds to the hash the contents of the files referred by @UnitsFile and @FlowsFile in text[begin, end)
+	inline uint64_t HashReferencedFiles(const std::string& text, const size_t begin, const size_t end, uint64_t hash)
+	{
+		const char* keywords[] = { "@UnitsFile", "@FlowsFile" };
+		for (unsigned int k = 0; k < 2; k++)
+		{
+			for (size_t position = text.find(keywords[k], begin); position < end; position = text.find(keywords[k], position + 1))
+			{
+				std::istringstream line(text.substr(position, end - position));
+				std::string keyword, path;
+				line >> keyword >> path;
+				if (keyword != keywords[k])
+					continue;
+				if (!path.empty() && path[path.size() - 1] == ';')
+					path.erase(path.size() - 1);
+
+				// A missing file is reported by the grammar, here only its name contributes to the hash
+				hash = HashBytes(path.data(), path.size(), hash);
+				std::ifstream fInput(path.c_str(), std::ios::in | std::ios::binary);
+				if (fInput.is_open())
+				{
+					std::stringstream buffer;
+					buffer << fInput.rdbuf();
+					const std::string contents = buffer.str();
+					hash = HashBytes(contents.data(), contents.size(), hash);
+				}
+			}
+		}
+		return hash;
+	}
+
+	//!  Hash of the network definition contained in an input file
+	/*!
+		 The top-level "Dictionary <name> { ... }" blocks listed in excluded_dictionaries
+		 (typically the ones referred by @Options and @OdeParameters) do not contribute to
+		 the hash, so that changing the numerical options does not invalidate the cache.
+		 The contents of the UnitsFile and FlowsFile of the reactor blocks are part of the hash.
+	*/
+	inline uint64_t NetworkSourceHash(const boost::filesystem::path& file_name, const std::vector<std::string>& excluded_dictionaries)
+	{
+		std::ifstream fInput(file_name.c_str(), std::ios::in | std::ios::binary);
+		if (!fInput.is_open())
+			OpenSMOKE::FatalErrorMessage("Unable to open file: " + file_name.string());
+		std::stringstream buffer;
+		buffer << fInput.rdbuf();
+		const std::string text = buffer.str();
+
+		uint64_t hash = HashBytes(0, 0);
+		size_t start = 0;
+		for (;;)
+		{
+			const size_t begin = text.find("Dictionary", start);
+			if (begin == std::string::npos)
+			{
+				hash = HashBytes(text.data() + start, text.size() - start, hash);
+				hash = HashReferencedFiles(text, start, text.size(), hash);
+				break;
+			}
+
+			const size_t open = text.find('{', begin);
+			if (open == std::string::npos)
+			{
+				hash = HashBytes(text.data() + start, text.size() - start, hash);
+				hash = HashReferencedFiles(text, start, text.size(), hash);
+				break;
+			}
+
+			// Matching closing brace
+			size_t close = open;
+			for (int depth = 0; close < text.size(); close++)
+			{
+				if (text[close] == '{')			depth++;
+				else if (text[close] == '}' && --depth == 0)	break;
+			}
+
+			std::istringstream header(text.substr(begin, open - begin));
+			std::string keyword, name;
+			header >> keyword >> name;
+
+			const size_t end = std::min(close + 1, text.size());
+			if (std::find(excluded_dictionaries.begin(), excluded_dictionaries.end(), name) != excluded_dictionaries.end())
+				hash = HashBytes(text.data() + start, begin - start, hash);
+			else
+			{
+				hash = HashBytes(text.data() + start, end - start, hash);
+				hash = HashReferencedFiles(text, start, end, hash);
+			}
+			start = end;
+		}
+
+		return hash;
+	}
+
+	//!  Binary cache of the compiled network
+	/*!
+		 The cache stores the NetworkTopology (units, streams, SI unit properties) together with
+		 the hash of the input file it was compiled from. On the following runs the file is
+		 memory-mapped and, if version and hash match, the topology is copied back without parsing
+		 the @Reactors/@Mixers/@Splitters/@PhaseSplitters dictionaries.
+		 The format is native-endian and is not meant to be moved across architectures.
+	*/
+	class NetworkCache
+	{
+	public:
+
+		static const uint32_t Version = 2;
+
+		static void Write(const boost::filesystem::path& file_name, const uint64_t source_hash, const NetworkTopology& topology)
+		{
+			const boost::filesystem::path tmp_name = file_name.string() + ".tmp";
+			{
+				std::ofstream fOutput(tmp_name.c_str(), std::ios::out | std::ios::binary);
+				if (!fOutput.is_open())
+					OpenSMOKE::FatalErrorMessage("Unable to write the network cache: " + tmp_name.string());
+
+				const uint32_t version = Version;
+				fOutput.write(Magic(), 8);
+				WriteBinaryScalar(fOutput, version);
+				WriteBinaryScalar(fOutput, source_hash);
+				WriteBinaryScalar(fOutput, topology.number_of_units_);
+				WriteBinaryScalar(fOutput, topology.number_of_streams_);
+
+				WriteBinaryArray(fOutput, topology.inlet_ptr_);
+				WriteBinaryArray(fOutput, topology.inlet_streams_);
+				WriteBinaryArray(fOutput, topology.outlet_ptr_);
+				WriteBinaryArray(fOutput, topology.outlet_streams_);
+				WriteBinaryArray(fOutput, topology.stream_ids_);
+				WriteBinaryArray(fOutput, topology.stream_source_);
+				WriteBinaryArray(fOutput, topology.stream_target_);
+				WriteBinaryArray(fOutput, topology.stream_phase_);
+				WriteBinaryArray(fOutput, topology.stream_mass_flow_);
+				WriteBinaryArray(fOutput, topology.successor_ptr_);
+				WriteBinaryArray(fOutput, topology.successors_);
+				WriteBinaryArray(fOutput, topology.predecessor_ptr_);
+				WriteBinaryArray(fOutput, topology.predecessors_);
+				WriteBinaryArray(fOutput, topology.unit_type_);
+				WriteBinaryArray(fOutput, topology.unit_energy_);
+				WriteBinaryArray(fOutput, topology.volume_);
+				WriteBinaryArray(fOutput, topology.residence_time_);
+				WriteBinaryArray(fOutput, topology.UA_);
+				WriteBinaryArray(fOutput, topology.temperature_);
+				WriteBinaryArray(fOutput, topology.pressure_);
+				WriteBinaryArray(fOutput, topology.diameter_);
+				WriteBinaryArray(fOutput, topology.length_);
+
+				WriteBinaryStrings(fOutput, topology.unit_names_);
+			}
+
+			// The cache is replaced only once it is complete
+			boost::filesystem::rename(tmp_name, file_name);
+		}
+
+		//! Returns false (and leaves the topology untouched) if the cache is missing or stale
+		static bool Read(const boost::filesystem::path& file_name, const uint64_t source_hash, NetworkTopology& topology)
+		{
+			if (boost::filesystem::exists(file_name) == false)
+				return false;
+
+			boost::iostreams::mapped_file_source file;
+			try
+			{
+				file.open(file_name.string());
+			}
+			catch (const std::exception&)
+			{
+				return false;
+			}
+			if (file.is_open() == false)
+				return false;
+
+			const char* data = file.data();
+			const char* end = data + file.size();
+
+			if (file.size() < 8 || std::memcmp(data, Magic(), 8) != 0)
+				return false;
+			data += 8;
+
+			uint32_t version;
+			uint64_t hash;
+			if (ReadBinaryScalar(data, end, version) == false || version != Version)
+				return false;
+			if (ReadBinaryScalar(data, end, hash) == false || hash != source_hash)
+				return false;
+
+			NetworkTopology cached;
+			bool ok = ReadBinaryScalar(data, end, cached.number_of_units_);
+			ok = ok && ReadBinaryScalar(data, end, cached.number_of_streams_);
+
+			ok = ok && ReadBinaryArray(data, end, cached.inlet_ptr_);
+			ok = ok && ReadBinaryArray(data, end, cached.inlet_streams_);
+			ok = ok && ReadBinaryArray(data, end, cached.outlet_ptr_);
+			ok = ok && ReadBinaryArray(data, end, cached.outlet_streams_);
+			ok = ok && ReadBinaryArray(data, end, cached.stream_ids_);
+			ok = ok && ReadBinaryArray(data, end, cached.stream_source_);
+			ok = ok && ReadBinaryArray(data, end, cached.stream_target_);
+			ok = ok && ReadBinaryArray(data, end, cached.stream_phase_);
+			ok = ok && ReadBinaryArray(data, end, cached.stream_mass_flow_);
+			ok = ok && ReadBinaryArray(data, end, cached.successor_ptr_);
+			ok = ok && ReadBinaryArray(data, end, cached.successors_);
+			ok = ok && ReadBinaryArray(data, end, cached.predecessor_ptr_);
+			ok = ok && ReadBinaryArray(data, end, cached.predecessors_);
+			ok = ok && ReadBinaryArray(data, end, cached.unit_type_);
+			ok = ok && ReadBinaryArray(data, end, cached.unit_energy_);
+			ok = ok && ReadBinaryArray(data, end, cached.volume_);
+			ok = ok && ReadBinaryArray(data, end, cached.residence_time_);
+			ok = ok && ReadBinaryArray(data, end, cached.UA_);
+			ok = ok && ReadBinaryArray(data, end, cached.temperature_);
+			ok = ok && ReadBinaryArray(data, end, cached.pressure_);
+			ok = ok && ReadBinaryArray(data, end, cached.diameter_);
+			ok = ok && ReadBinaryArray(data, end, cached.length_);
+
+			ok = ok && ReadBinaryStrings(data, end, cached.unit_names_);
+			if (ok == false)
+				return false;
+
+			// A damaged cache must not produce out-of-range accesses: lengths, CSR pointers and indices are checked
+			const unsigned int nu = cached.number_of_units_;
+			const unsigned int ns = cached.number_of_streams_;
+			ok = IsValidPointerArray(cached.inlet_ptr_, nu, cached.inlet_streams_.size());
+			ok = ok && IsValidPointerArray(cached.outlet_ptr_, nu, cached.outlet_streams_.size());
+			ok = ok && IsValidPointerArray(cached.successor_ptr_, nu, cached.successors_.size());
+			ok = ok && IsValidPointerArray(cached.predecessor_ptr_, nu, cached.predecessors_.size());
+			ok = ok && AreInRange(cached.inlet_streams_, 0u, ns) && AreInRange(cached.outlet_streams_, 0u, ns);
+			ok = ok && AreInRange(cached.successors_, 0u, nu) && AreInRange(cached.predecessors_, 0u, nu);
+			ok = ok && cached.stream_ids_.size() == ns && cached.stream_phase_.size() == ns && cached.stream_mass_flow_.size() == ns;
+			ok = ok && cached.stream_source_.size() == ns && AreInRange(cached.stream_source_, NoUnit, static_cast<int>(nu));
+			ok = ok && cached.stream_target_.size() == ns && AreInRange(cached.stream_target_, NoUnit, static_cast<int>(nu));
+			ok = ok && cached.unit_names_.size() == nu && cached.unit_type_.size() == nu && cached.unit_energy_.size() == nu;
+			ok = ok && cached.volume_.size() == nu && cached.residence_time_.size() == nu && cached.UA_.size() == nu;
+			ok = ok && cached.temperature_.size() == nu && cached.pressure_.size() == nu;
+			ok = ok && cached.diameter_.size() == nu && cached.length_.size() == nu;
+			if (ok == false)
+				return false;
+
+			for (unsigned int s = 0; s < ns; s++)
+				cached.stream_index_[cached.stream_ids_[s]] = s;
+			if (cached.stream_index_.size() != ns)
+				return false;
+
+			std::swap(topology, cached);
+			return true;
+		}
+
+	private:
+
+		static const char* Magic() { return "NSMKNET"; }	// 7 characters + terminator
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKCACHE_H */
@@ -0,0 +1,206 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKCHANGETRACKER_H
+#define NETSMOKE_NETWORKCHANGETRACKER_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include "NetworkTopology.h"
+#include "NetworkSolveOrder.h"
+#include "NetworkCache.h"
+#include "StreamStateArena.h"
+
+namespace NetSMOKE
+{
+	//!  Incremental re-solution of the network after parameter changes
+	/*!
+		 The inputs of every block (parameters of its units, mass flow rates given for their
+		 outlet streams, state of the streams entering the network) are hashed and compared
+		 with the ones of the last converged solution. A block is solved again only if its
+		 inputs changed or if a block upstream produced different outlet streams in this run,
+		 so that dirtiness propagates only downstream and stops as soon as the outlet streams
+		 of a re-solved block do not change. Skipped blocks keep their previous (converged)
+		 state in the StreamStateArena, which is also the initial guess of the re-solved ones.
+
+		 Stream states are hashed after rounding to the solver tolerances (the ones of the
+		 reactors, i.e. given to SetTolerances of the BatchedPSRSolver and SparsePSRSolver,
+		 1e-12 and 1e-7 by default): values below the absolute tolerance are hashed as zero
+		 and the others are rounded to the number of significant bits of the relative
+		 tolerance, so that most changes below the tolerances (not all: a value can still
+		 cross a rounding boundary) do not propagate.
+
+		 Usage inside the block solver passed to the NetworkTaskScheduler:
+			if (tracker.NeedsSolve(b, arena) == false) return;
+			... solve block b ...
+			tracker.BlockSolved(b, arena);
+	*/
+	class NetworkChangeTracker
+	{
+	public:
+
+		NetworkChangeTracker(const NetworkTopology& topology, const NetworkSolveOrder& order,
+							const double absolute_tolerance = 1.e-12, const double relative_tolerance = 1.e-7) :
+			topology_(topology),
+			order_(order),
+			absolute_tolerance_(absolute_tolerance),
+			significant_bits_(std::max(1, std::min(52, static_cast<int>(std::ceil(-std::log2(relative_tolerance))))))
+		{
+			Invalidate();
+		}
+
+		//! Significant bits kept in the hash of the stream states
+		int OutputSignificantBits() const { return significant_bits_; }
+
+		//! Forces a complete solution at the next run (i.e. cold start)
+		void Invalidate()
+		{
+			const unsigned int nb = order_.NumberOfBlocks();
+			input_hash_.assign(nb, 0);
+			output_hash_.assign(nb, 0);
+			solved_.assign(nb, 0);
+			dirty_.assign(nb, 1);
+			output_changed_.assign(nb, 1);
+		}
+
+		//! True if block b must be solved in this run (to be called when its predecessors are done)
+		bool NeedsSolve(const unsigned int b, const StreamStateArena& arena)
+		{
+			bool dirty = (solved_[b] == 0) || (InputHash(b, arena) != input_hash_[b]);
+
+			const std::vector<unsigned int>& ptr = order_.BlockPredecessorPtr();
+			const std::vector<unsigned int>& predecessors = order_.BlockPredecessors();
+			for (unsigned int j = ptr[b]; j < ptr[b + 1] && dirty == false; j++)
+				dirty = (output_changed_[predecessors[j]] != 0);
+
+			dirty_[b] = dirty ? 1 : 0;
+			if (dirty == false)
+				output_changed_[b] = 0;
+			return dirty;
+		}
+
+		//! Stores the inputs and outlet streams of the converged block b
+		void BlockSolved(const unsigned int b, const StreamStateArena& arena)
+		{
+			const uint64_t hash = OutputHash(b, arena);
+			output_changed_[b] = (solved_[b] == 0 || hash != output_hash_[b]) ? 1 : 0;
+			output_hash_[b] = hash;
+			input_hash_[b] = InputHash(b, arena);
+			solved_[b] = 1;
+		}
+
+		//! Number of blocks solved in the last run
+		unsigned int NumberOfSolvedBlocks() const
+		{
+			unsigned int n = 0;
+			for (unsigned int b = 0; b < dirty_.size(); b++)
+				n += dirty_[b];
+			return n;
+		}
+
+	private:
+
+		static uint64_t HashDouble(double value, const uint64_t hash)
+		{
+			return HashBytes(reinterpret_cast<const char*>(&value), sizeof(double), hash);
+		}
+
+		uint64_t HashRounded(const double value, const uint64_t hash) const
+		{
+			if (std::fabs(value) <= absolute_tolerance_)
+				return HashDouble(0., hash);
+
+			int exponent;
+			const double mantissa = std::frexp(value, &exponent);
+			const double scale = std::ldexp(1., significant_bits_);
+			return HashDouble(std::ldexp(std::floor(mantissa * scale + 0.5) / scale, exponent), hash);
+		}
+
+		uint64_t StreamHash(const unsigned int s, const StreamStateArena& arena, uint64_t hash) const
+		{
+			const double* omega = arena.MassFractions(s);
+			for (unsigned int i = 0; i < arena.NumberOfSpecies(); i++)
+				hash = HashRounded(omega[i], hash);
+			hash = HashRounded(arena.Temperature(s), hash);
+			hash = HashRounded(arena.Pressure(s), hash);
+			return HashRounded(arena.MassFlow(s), hash);
+		}
+
+		//! Parameters of the units of the block and state of the streams entering the network
+		uint64_t InputHash(const unsigned int b, const StreamStateArena& arena) const
+		{
+			uint64_t hash = HashBytes(0, 0);
+			for (unsigned int j = order_.BlockPtr()[b]; j < order_.BlockPtr()[b + 1]; j++)
+			{
+				const unsigned int k = order_.BlockUnits()[j];
+				const double parameters[7] = { topology_.Volume()[k], topology_.ResidenceTime()[k], topology_.UA()[k],
+												topology_.Temperature()[k], topology_.Pressure()[k],
+												topology_.Diameter()[k], topology_.Length()[k] };
+				hash = HashBytes(reinterpret_cast<const char*>(parameters), sizeof(parameters), hash);
+
+				for (unsigned int i = topology_.OutletPtr()[k]; i < topology_.OutletPtr()[k + 1]; i++)
+					hash = HashDouble(topology_.StreamMassFlow()[topology_.OutletStreams()[i]], hash);
+
+				for (unsigned int i = topology_.InletPtr()[k]; i < topology_.InletPtr()[k + 1]; i++)
+				{
+					const unsigned int s = topology_.InletStreams()[i];
+					if (topology_.StreamSource()[s] == NoUnit)
+						hash = StreamHash(s, arena, hash);
+				}
+			}
+			return hash;
+		}
+
+		//! Streams leaving the block
+		uint64_t OutputHash(const unsigned int b, const StreamStateArena& arena) const
+		{
+			uint64_t hash = HashBytes(0, 0);
+			for (unsigned int j = order_.BlockPtr()[b]; j < order_.BlockPtr()[b + 1]; j++)
+			{
+				const unsigned int k = order_.BlockUnits()[j];
+				for (unsigned int i = topology_.OutletPtr()[k]; i < topology_.OutletPtr()[k + 1]; i++)
+				{
+					const unsigned int s = topology_.OutletStreams()[i];
+					const int target = topology_.StreamTarget()[s];
+					if (target == NoUnit || order_.UnitBlock()[target] != b)
+						hash = StreamHash(s, arena, hash);
+				}
+			}
+			return hash;
+		}
+
+	private:
+
+		const NetworkTopology& topology_;
+		const NetworkSolveOrder& order_;
+		double absolute_tolerance_;
+		int significant_bits_;
+
+		std::vector<uint64_t> input_hash_;
+		std::vector<uint64_t> output_hash_;
+
+		// One char per block, since they are written concurrently by the tasks of different blocks
+		std::vector<char> solved_;
+		std::vector<char> dirty_;
+		std::vector<char> output_changed_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKCHANGETRACKER_H */
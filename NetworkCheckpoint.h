@@ -0,0 +1,263 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKCHECKPOINT_H
+#define NETSMOKE_NETWORKCHECKPOINT_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <stdint.h>
+#include "boost/filesystem.hpp"
+#include "boost/iostreams/device/mapped_file.hpp"
+#include "NetworkTopology.h"
+#include "NetworkCache.h"
+#include "StreamStateArena.h"
+
+namespace NetSMOKE
+{
+	//!  Binary checkpoint of the network state, used as initial guess of a following run
+	/*!
+		 For every unit (identified by its name) the checkpoint stores the state of its outlet
+		 streams (mass fractions, T, P, mass flow rate) and the number of iterations of its
+		 recycle block. The streams entering the network are not stored: they are given by the
+		 input of the current run, which may have changed since the checkpoint.
+		 Species are stored by name.
+		 On restart the state is copied only for the units with the same name in the current
+		 network (outlets matched by position, or by stream ID if their number changed) and for
+		 the species of the current kinetic scheme: units and species added or removed since the
+		 checkpoint are simply left to their cold initial guess.
+		 The format is native-endian and is not meant to be moved across architectures.
+	*/
+	class NetworkCheckpoint
+	{
+	public:
+
+		static const uint32_t Version = 2;
+
+		//! Periodic checkpoints every interval seconds (see IsDue)
+		NetworkCheckpoint(const boost::filesystem::path& file_name, const double interval) :
+			file_name_(file_name),
+			interval_(interval),
+			last_(std::chrono::steady_clock::now())
+		{
+		}
+
+		bool IsDue() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - last_).count() >= interval_;
+		}
+
+		//! Returns false if the checkpoint could not be written (it is tried again after interval seconds)
+		bool Write(const NetworkTopology& topology, const StreamStateArena& arena, const std::vector<std::string>& species_names,
+					const std::vector<uint32_t>& recycle_iterations)
+		{
+			const bool written = WriteFile(file_name_, topology, arena, species_names, recycle_iterations);
+			last_ = std::chrono::steady_clock::now();
+			return written;
+		}
+
+		//! recycle_iterations: number of iterations of the recycle block of each unit (0 if not in a recycle)
+		//! Returns false (keeping the previous checkpoint) if the file could not be written, i.e. disk full
+		static bool WriteFile(const boost::filesystem::path& file_name, const NetworkTopology& topology, const StreamStateArena& arena,
+							const std::vector<std::string>& species_names, const std::vector<uint32_t>& recycle_iterations)
+		{
+			const unsigned int ns = arena.NumberOfSpecies();
+			const unsigned int nu = topology.NumberOfUnits();
+
+			const std::vector<unsigned int>& streams = topology.OutletStreams();
+
+			std::vector<int> outlet_ids(topology.OutletStreams().size());
+			for (unsigned int j = 0; j < outlet_ids.size(); j++)
+				outlet_ids[j] = topology.StreamIDs()[topology.OutletStreams()[j]];
+
+			std::vector<double> omega(streams.size() * static_cast<size_t>(ns));
+			std::vector<double> T(streams.size()), P(streams.size()), mass_flow(streams.size());
+			for (unsigned int j = 0; j < streams.size(); j++)
+			{
+				std::memcpy(&omega[static_cast<size_t>(j) * ns], arena.MassFractions(streams[j]), ns * sizeof(double));
+				T[j] = arena.Temperature(streams[j]);
+				P[j] = arena.Pressure(streams[j]);
+				mass_flow[j] = arena.MassFlow(streams[j]);
+			}
+
+			const boost::filesystem::path tmp_name = file_name.string() + ".tmp";
+			{
+				std::ofstream fOutput(tmp_name.c_str(), std::ios::out | std::ios::binary);
+				if (!fOutput.is_open())
+					OpenSMOKE::FatalErrorMessage("Unable to write the checkpoint file: " + tmp_name.string());
+
+				const uint32_t version = Version;
+				fOutput.write(Magic(), 8);
+				WriteBinaryScalar(fOutput, version);
+				WriteBinaryStrings(fOutput, species_names);
+				WriteBinaryStrings(fOutput, topology.UnitNames());
+				WriteBinaryArray(fOutput, std::vector<uint32_t>(topology.OutletPtr().begin(), topology.OutletPtr().end()));
+				WriteBinaryArray(fOutput, outlet_ids);
+				WriteBinaryArray(fOutput, recycle_iterations.empty() ? std::vector<uint32_t>(nu, 0) : recycle_iterations);
+				WriteBinaryArray(fOutput, omega);
+				WriteBinaryArray(fOutput, T);
+				WriteBinaryArray(fOutput, P);
+				WriteBinaryArray(fOutput, mass_flow);
+
+				fOutput.close();
+				if (fOutput.fail())
+				{
+					boost::system::error_code ec;
+					boost::filesystem::remove(tmp_name, ec);
+					return false;
+				}
+			}
+
+			// A crash while writing does not destroy the previous checkpoint
+			boost::filesystem::rename(tmp_name, file_name);
+			return true;
+		}
+
+		//! Copies the matching part of the checkpoint into the arena, returns the number of units restored
+		static unsigned int ReadFile(const boost::filesystem::path& file_name, const NetworkTopology& topology, const std::vector<std::string>& species_names,
+									StreamStateArena& arena, std::vector<uint32_t>& recycle_iterations)
+		{
+			recycle_iterations.assign(topology.NumberOfUnits(), 0);
+
+			if (boost::filesystem::exists(file_name) == false)
+				OpenSMOKE::FatalErrorMessage("The restart file does not exist: " + file_name.string());
+
+			boost::iostreams::mapped_file_source file(file_name.string());
+			const char* data = file.data();
+			const char* end = data + file.size();
+
+			if (file.size() < 8 || std::memcmp(data, Magic(), 8) != 0)
+				OpenSMOKE::FatalErrorMessage("The file " + file_name.string() + " is not a NetSMOKE checkpoint");
+			data += 8;
+
+			uint32_t version;
+			std::vector<std::string> old_species, old_units;
+			std::vector<uint32_t> old_outlet_ptr, old_iterations;
+			std::vector<int> old_outlet_ids;
+			std::vector<double> omega, T, P, mass_flow;
+
+			bool ok = ReadBinaryScalar(data, end, version) && version == Version;
+			ok = ok && ReadBinaryStrings(data, end, old_species);
+			ok = ok && ReadBinaryStrings(data, end, old_units);
+			ok = ok && ReadBinaryArray(data, end, old_outlet_ptr);
+			ok = ok && ReadBinaryArray(data, end, old_outlet_ids);
+			ok = ok && ReadBinaryArray(data, end, old_iterations);
+			ok = ok && ReadBinaryArray(data, end, omega);
+			ok = ok && ReadBinaryArray(data, end, T);
+			ok = ok && ReadBinaryArray(data, end, P);
+			ok = ok && ReadBinaryArray(data, end, mass_flow);
+
+			const size_t old_streams = old_outlet_ids.size();
+			ok = ok && IsValidPointerArray(old_outlet_ptr, old_units.size(), old_outlet_ids.size());
+			ok = ok && old_iterations.size() == old_units.size();
+			ok = ok && T.size() == old_streams && P.size() == old_streams && mass_flow.size() == old_streams;
+			ok = ok && omega.size() == old_streams * old_species.size();
+			if (ok == false)
+				OpenSMOKE::FatalErrorMessage("The checkpoint file " + file_name.string() + " is corrupted or has a different version");
+
+			// Species of the checkpoint -> species of the current kinetic scheme
+			std::vector<int> species_map(old_species.size(), -1);
+			{
+				std::map<std::string, int> current;
+				for (unsigned int i = 0; i < species_names.size(); i++)
+					current[species_names[i]] = static_cast<int>(i);
+				for (unsigned int i = 0; i < old_species.size(); i++)
+				{
+					std::map<std::string, int>::const_iterator it = current.find(old_species[i]);
+					if (it != current.end())
+						species_map[i] = it->second;
+				}
+			}
+
+			std::map<std::string, unsigned int> units;
+			for (unsigned int k = 0; k < old_units.size(); k++)
+				units[old_units[k]] = k;
+
+			unsigned int restored = 0;
+			for (unsigned int k = 0; k < topology.NumberOfUnits(); k++)
+			{
+				std::map<std::string, unsigned int>::const_iterator it = units.find(topology.UnitNames()[k]);
+				if (it == units.end())
+					continue;
+
+				const unsigned int u = it->second;
+				const unsigned int first = topology.OutletPtr()[k];
+				const unsigned int n = topology.OutletPtr()[k + 1] - first;
+				const unsigned int old_first = old_outlet_ptr[u];
+				const unsigned int old_n = old_outlet_ptr[u + 1] - old_first;
+
+				for (unsigned int j = 0; j < n; j++)
+				{
+					const unsigned int s = topology.OutletStreams()[first + j];
+					int old_j = (n == old_n) ? static_cast<int>(j) : -1;
+					for (unsigned int i = 0; i < old_n && old_j < 0; i++)
+						if (old_outlet_ids[old_first + i] == topology.StreamIDs()[s])
+							old_j = static_cast<int>(i);
+					if (old_j >= 0)
+						CopyStream(old_first + old_j, s, species_map, omega, T, P, mass_flow, arena);
+				}
+
+				recycle_iterations[k] = old_iterations[u];
+				restored++;
+			}
+
+			return restored;
+		}
+
+	private:
+
+		static const char* Magic() { return "NSMKRST"; }	// 7 characters + terminator
+
+		//! Copies the old stream j into stream s, renormalizing the mass fractions of the species still available
+		static void CopyStream(const unsigned int j, const unsigned int s, const std::vector<int>& species_map,
+								const std::vector<double>& omega, const std::vector<double>& T, const std::vector<double>& P,
+								const std::vector<double>& mass_flow, StreamStateArena& arena)
+		{
+			double* y = arena.MassFractions(s);
+			std::fill(y, y + arena.NumberOfSpecies(), 0.);
+
+			const size_t ns = species_map.size();
+			double sum = 0.;
+			for (unsigned int i = 0; i < ns; i++)
+				if (species_map[i] >= 0)
+				{
+					y[species_map[i]] = omega[j * ns + i];
+					sum += omega[j * ns + i];
+				}
+			if (sum > 0.)
+				for (unsigned int i = 0; i < arena.NumberOfSpecies(); i++)
+					y[i] /= sum;
+
+			arena.Temperature(s) = T[j];
+			arena.Pressure(s) = P[j];
+			arena.MassFlow(s) = mass_flow[j];
+		}
+
+	private:
+
+		boost::filesystem::path file_name_;
+		double interval_;
+		std::chrono::steady_clock::time_point last_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKCHECKPOINT_H */
@@ -0,0 +1,448 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKNEWTONSOLVER_H
+#define NETSMOKE_NETWORKNEWTONSOLVER_H
+
+#include <vector>
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include "Eigen/Dense"
+#include "Eigen/Sparse"
+#include "NetworkTopology.h"
+#include "NetworkTelemetry.h"
+
+namespace NetSMOKE
+{
+	enum NetworkSolverType { NETWORK_SOLVER_SEQUENTIAL_MODULAR, NETWORK_SOLVER_GLOBAL_NEWTON };
+	enum NewtonLinearSolverType { NEWTON_LINEAR_SOLVER_SPARSELU, NEWTON_LINEAR_SOLVER_BICGSTAB };
+
+	inline NetworkSolverType NetworkSolverTypeFromString(const std::string& solver)
+	{
+		if (solver == "SequentialModular")		return NETWORK_SOLVER_SEQUENTIAL_MODULAR;
+		else if (solver == "GlobalNewton")		return NETWORK_SOLVER_GLOBAL_NEWTON;
+		else OpenSMOKE::FatalErrorMessage("Unknown @NetworkSolver: " + solver + " (use SequentialModular, GlobalNewton)");
+		return NETWORK_SOLVER_SEQUENTIAL_MODULAR;
+	}
+
+	inline NewtonLinearSolverType NewtonLinearSolverTypeFromString(const std::string& solver)
+	{
+		if (solver == "SparseLU")				return NEWTON_LINEAR_SOLVER_SPARSELU;
+		else if (solver == "BiCGSTAB")			return NEWTON_LINEAR_SOLVER_BICGSTAB;
+		else OpenSMOKE::FatalErrorMessage("Unknown @NewtonLinearSolver: " + solver + " (use SparseLU, BiCGSTAB)");
+		return NEWTON_LINEAR_SOLVER_SPARSELU;
+	}
+
+	//!  Block-Jacobi preconditioner for the Eigen iterative solvers
+	/*!
+		 The diagonal blocks (one per unit) are extracted from the network Jacobian and
+		 factorized with dense LU. The block size must be set before compute() is called.
+	*/
+	class BlockJacobiPreconditioner
+	{
+	public:
+
+		typedef Eigen::VectorXd::Index Index;
+
+		BlockJacobiPreconditioner() : block_size_(1), info_(Eigen::Success) {}
+
+		void SetBlockSize(const unsigned int block_size) { block_size_ = block_size; }
+
+		template<typename MatrixType>
+		BlockJacobiPreconditioner& analyzePattern(const MatrixType&) { return *this; }
+
+		template<typename MatrixType>
+		BlockJacobiPreconditioner& factorize(const MatrixType& matrix)
+		{
+			const unsigned int n = static_cast<unsigned int>(matrix.rows()) / block_size_;
+			blocks_.resize(n);
+			Eigen::MatrixXd dense(block_size_, block_size_);
+			for (unsigned int k = 0; k < n; k++)
+			{
+				const Index first = static_cast<Index>(k * block_size_);
+				dense.setZero();
+				for (unsigned int j = 0; j < block_size_; j++)
+					for (typename MatrixType::InnerIterator it(matrix, first + j); it; ++it)
+						if (it.row() >= first && it.row() < first + block_size_)
+							dense(it.row() - first, j) = it.value();
+				blocks_[k].compute(dense);
+			}
+			info_ = Eigen::Success;
+			return *this;
+		}
+
+		template<typename MatrixType>
+		BlockJacobiPreconditioner& compute(const MatrixType& matrix) { return factorize(matrix); }
+
+		template<typename Rhs>
+		Eigen::VectorXd solve(const Rhs& b) const
+		{
+			Eigen::VectorXd x(b.size());
+			for (unsigned int k = 0; k < blocks_.size(); k++)
+				x.segment(k * block_size_, block_size_) = blocks_[k].solve(b.segment(k * block_size_, block_size_));
+			return x;
+		}
+
+		Eigen::ComputationInfo info() { return info_; }
+
+	private:
+
+		unsigned int block_size_;
+		std::vector< Eigen::PartialPivLU<Eigen::MatrixXd> > blocks_;
+		Eigen::ComputationInfo info_;
+	};
+
+	//!  Simultaneous (equation-oriented) solution of the whole reactor network
+	/*!
+		 The unknowns are stored unit by unit (BlockSize() values per unit, e.g. species and
+		 temperature). The residuals of a unit depend on its own unknowns and on the unknowns of
+		 the units feeding its inlet streams, so that the Jacobian has the sparsity of the unit
+		 graph at block level. The Jacobian is evaluated by finite differences with a greedy
+		 distance-2 coloring of the units, i.e. all the units of a color are perturbed at once.
+
+		 The NetworkEquations class must provide:
+		 - unsigned int BlockSize() const
+		 - void Residuals(const Eigen::VectorXd& y, Eigen::VectorXd& f)
+
+		 If the damped Newton iteration fails, the solver falls back to pseudo-transient
+		 continuation (backward Euler steps with growing time step). The absolute and relative
+		 tolerances of both are @NewtonAbsoluteTolerance and @NewtonRelativeTolerance of the
+		 @Options dictionary (NetworkOptions), passed with SetTolerances.
+	*/
+	template<typename NetworkEquations>
+	class NetworkNewtonSolver
+	{
+	public:
+
+		NetworkNewtonSolver(const NetworkTopology& topology, NetworkEquations& equations) :
+			topology_(topology),
+			equations_(equations),
+			block_size_(equations.BlockSize()),
+			linear_solver_(NEWTON_LINEAR_SOLVER_SPARSELU),
+			max_iterations_(50),
+			max_pseudo_transient_steps_(500),
+			absolute_tolerance_(1.e-12),
+			relative_tolerance_(1.e-7),
+			pattern_analyzed_(false),
+			telemetry_(nullptr)
+		{
+			const unsigned int n = topology_.NumberOfUnits();
+			size_ = n * block_size_;
+			ColorUnits();
+			BuildPattern();
+		}
+
+		void SetLinearSolver(const NewtonLinearSolverType type) { linear_solver_ = type; }
+		void SetMaxIterations(const unsigned int n) { max_iterations_ = n; }
+		void SetMaxPseudoTransientSteps(const unsigned int n) { max_pseudo_transient_steps_ = n; }
+		void SetTolerances(const double absolute, const double relative) { absolute_tolerance_ = absolute; relative_tolerance_ = relative; }
+
+		//! Telemetry receiving the network counters and residual history (null: none); pseudo-transient steps count as iterations
+		void SetTelemetry(NetworkTelemetry* telemetry) { telemetry_ = telemetry; }
+
+		unsigned int NumberOfColors() const { return number_of_colors_; }
+
+		//! Solves F(y) = 0 starting from y, returns true on convergence
+		bool Solve(Eigen::VectorXd& y)
+		{
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			bool converged = Newton(y);
+			if (converged == false)
+			{
+				std::cout << "Global Newton did not converge: switching to pseudo-transient continuation" << std::endl;
+				converged = PseudoTransient(y) && Newton(y);
+			}
+
+			if (telemetry_ != nullptr)
+			{
+				UnitCounters& counters = telemetry_->Network();
+				counters.wall_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				counters.calls++;
+				if (converged == false)
+					counters.failures++;
+			}
+			return converged;
+		}
+
+	private:
+
+		//! Iteration of the Newton or pseudo-transient method with residual norm
+		void RecordIteration(const double norm)
+		{
+			if (telemetry_ != nullptr)
+			{
+				telemetry_->Network().newton_iterations++;
+				telemetry_->RecordNetworkIteration(norm);
+			}
+		}
+
+		bool Newton(Eigen::VectorXd& y)
+		{
+			Eigen::VectorXd f(size_), f_trial(size_), dy(size_), y_trial(size_);
+			equations_.Residuals(y, f);
+			double norm = f.norm();
+
+			for (unsigned int k = 0; k < max_iterations_; k++)
+			{
+				if (Converged(y, f) == true)
+					return true;
+
+				Jacobian(y, f);
+				if (LinearSolve(-f, dy) == false)
+					return false;
+
+				// Backtracking on the residual norm
+				double lambda = 1.;
+				for (;;)
+				{
+					y_trial = y + lambda * dy;
+					equations_.Residuals(y_trial, f_trial);
+					if (f_trial.norm() < (1. - 1.e-4 * lambda) * norm)
+						break;
+					lambda *= 0.5;
+					if (lambda < 1.e-4)
+						return false;
+				}
+
+				y = y_trial;
+				f = f_trial;
+				norm = f.norm();
+				RecordIteration(norm);
+			}
+
+			return Converged(y, f);
+		}
+
+		bool PseudoTransient(Eigen::VectorXd& y)
+		{
+			Eigen::VectorXd f(size_), dy(size_);
+			equations_.Residuals(y, f);
+			double norm = f.norm();
+			double dt = 1.e-6;
+
+			for (unsigned int k = 0; k < max_pseudo_transient_steps_; k++)
+			{
+				// (I/dt - J) dy = f
+				Jacobian(y, f);
+				jacobian_ *= -1.;
+				for (unsigned int i = 0; i < size_; i++)
+					jacobian_.coeffRef(i, i) += 1. / dt;
+				if (LinearSolve(f, dy) == false)
+				{
+					dt *= 0.1;
+					continue;
+				}
+
+				y += dy;
+				equations_.Residuals(y, f);
+				const double norm_new = f.norm();
+
+				// Switched evolution relaxation
+				dt *= std::min(10., std::max(0.1, norm / std::max(norm_new, 1.e-300)));
+				norm = norm_new;
+				RecordIteration(norm);
+
+				if (norm < std::sqrt(relative_tolerance_))
+					return true;
+			}
+
+			return false;
+		}
+
+		bool Converged(const Eigen::VectorXd& y, const Eigen::VectorXd& f) const
+		{
+			for (unsigned int i = 0; i < size_; i++)
+				if (std::fabs(f(i)) > absolute_tolerance_ + relative_tolerance_ * std::fabs(y(i)))
+					return false;
+			return true;
+		}
+
+		void ColorUnits()
+		{
+			const unsigned int n = topology_.NumberOfUnits();
+			const std::vector<unsigned int>& sptr = topology_.SuccessorPtr();
+			const std::vector<unsigned int>& succ = topology_.Successors();
+			const std::vector<unsigned int>& pptr = topology_.PredecessorPtr();
+			const std::vector<unsigned int>& pred = topology_.Predecessors();
+
+			const int uncolored = -1;
+			std::vector<int> color(n, uncolored);
+			std::vector<unsigned int> forbidden;
+			number_of_colors_ = 0;
+
+			for (unsigned int j = 0; j < n; j++)
+			{
+				// Units whose columns touch the same rows as j: predecessors of j and of its successors
+				forbidden.assign(number_of_colors_ + 1, n);
+				for (unsigned int r = 0; r <= sptr[j + 1] - sptr[j]; r++)
+				{
+					const unsigned int row = (r == 0) ? j : succ[sptr[j] + r - 1];
+					if (color[row] != uncolored)	forbidden[color[row]] = j;
+					for (unsigned int i = pptr[row]; i < pptr[row + 1]; i++)
+						if (color[pred[i]] != uncolored)	forbidden[color[pred[i]]] = j;
+				}
+
+				unsigned int c = 0;
+				while (forbidden[c] == j)	c++;
+				color[j] = static_cast<int>(c);
+				number_of_colors_ = std::max(number_of_colors_, c + 1);
+			}
+
+			color_ptr_.assign(number_of_colors_ + 1, 0);
+			for (unsigned int j = 0; j < n; j++)
+				color_ptr_[color[j] + 1]++;
+			for (unsigned int c = 0; c < number_of_colors_; c++)
+				color_ptr_[c + 1] += color_ptr_[c];
+			color_units_.resize(n);
+			std::vector<unsigned int> position(color_ptr_.begin(), color_ptr_.end() - 1);
+			for (unsigned int j = 0; j < n; j++)
+				color_units_[position[color[j]]++] = j;
+		}
+
+		void BuildPattern()
+		{
+			const unsigned int n = topology_.NumberOfUnits();
+			const std::vector<unsigned int>& pptr = topology_.PredecessorPtr();
+			const std::vector<unsigned int>& pred = topology_.Predecessors();
+
+			std::vector< Eigen::Triplet<double> > triplets;
+			for (unsigned int r = 0; r < n; r++)
+			{
+				AddBlock(r, r, triplets);
+				for (unsigned int i = pptr[r]; i < pptr[r + 1]; i++)
+					if (pred[i] != r)
+						AddBlock(r, pred[i], triplets);
+			}
+
+			jacobian_.resize(size_, size_);
+			jacobian_.setFromTriplets(triplets.begin(), triplets.end());
+			jacobian_.makeCompressed();
+		}
+
+		void AddBlock(const unsigned int r, const unsigned int c, std::vector< Eigen::Triplet<double> >& triplets) const
+		{
+			for (unsigned int i = 0; i < block_size_; i++)
+				for (unsigned int j = 0; j < block_size_; j++)
+					triplets.push_back(Eigen::Triplet<double>(r * block_size_ + i, c * block_size_ + j, 0.));
+		}
+
+		void Jacobian(const Eigen::VectorXd& y, const Eigen::VectorXd& f)
+		{
+			if (telemetry_ != nullptr)
+				telemetry_->Network().jacobian_evaluations++;
+			const std::vector<unsigned int>& sptr = topology_.SuccessorPtr();
+			const std::vector<unsigned int>& succ = topology_.Successors();
+
+			// Keeps the pattern (and then the symbolic factorization) fixed
+			for (int k = 0; k < jacobian_.outerSize(); k++)
+				for (Eigen::SparseMatrix<double>::InnerIterator it(jacobian_, k); it; ++it)
+					it.valueRef() = 0.;
+
+			Eigen::VectorXd y_perturbed = y;
+			Eigen::VectorXd f_perturbed(size_);
+			std::vector<double> h(topology_.NumberOfUnits());
+
+			for (unsigned int c = 0; c < number_of_colors_; c++)
+				for (unsigned int i = 0; i < block_size_; i++)
+				{
+					for (unsigned int k = color_ptr_[c]; k < color_ptr_[c + 1]; k++)
+					{
+						const unsigned int j = color_units_[k];
+						const unsigned int col = j * block_size_ + i;
+						h[j] = std::sqrt(1.e-14) * std::max(std::fabs(y(col)), 1.e-5);
+						y_perturbed(col) = y(col) + h[j];
+					}
+
+					equations_.Residuals(y_perturbed, f_perturbed);
+
+					for (unsigned int k = color_ptr_[c]; k < color_ptr_[c + 1]; k++)
+					{
+						const unsigned int j = color_units_[k];
+						const unsigned int col = j * block_size_ + i;
+						y_perturbed(col) = y(col);
+
+						for (unsigned int r = 0; r <= sptr[j + 1] - sptr[j]; r++)
+						{
+							const unsigned int row_block = (r == 0) ? j : succ[sptr[j] + r - 1];
+							for (unsigned int m = 0; m < block_size_; m++)
+							{
+								const unsigned int row = row_block * block_size_ + m;
+								jacobian_.coeffRef(row, col) = (f_perturbed(row) - f(row)) / h[j];
+							}
+						}
+					}
+				}
+		}
+
+		bool LinearSolve(const Eigen::VectorXd& b, Eigen::VectorXd& x)
+		{
+			if (telemetry_ != nullptr)
+				telemetry_->Network().factorizations++;
+			if (linear_solver_ == NEWTON_LINEAR_SOLVER_SPARSELU)
+			{
+				if (pattern_analyzed_ == false)
+				{
+					lu_.analyzePattern(jacobian_);
+					pattern_analyzed_ = true;
+				}
+				lu_.factorize(jacobian_);
+				if (lu_.info() != Eigen::Success)
+					return false;
+				x = lu_.solve(b);
+				return true;
+			}
+			else
+			{
+				bicgstab_.preconditioner().SetBlockSize(block_size_);
+				bicgstab_.setTolerance(1.e-2 * relative_tolerance_);
+				bicgstab_.compute(jacobian_);
+				x = bicgstab_.solve(b);
+				return bicgstab_.info() == Eigen::Success;
+			}
+		}
+
+	private:
+
+		const NetworkTopology& topology_;
+		NetworkEquations& equations_;
+
+		unsigned int block_size_;
+		unsigned int size_;
+
+		NewtonLinearSolverType linear_solver_;
+		unsigned int max_iterations_;
+		unsigned int max_pseudo_transient_steps_;
+		double absolute_tolerance_;
+		double relative_tolerance_;
+
+		unsigned int number_of_colors_;
+		std::vector<unsigned int> color_ptr_;
+		std::vector<unsigned int> color_units_;
+
+		Eigen::SparseMatrix<double> jacobian_;
+		Eigen::SparseLU< Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > lu_;
+		Eigen::BiCGSTAB< Eigen::SparseMatrix<double>, BlockJacobiPreconditioner > bicgstab_;
+		bool pattern_analyzed_;
+		NetworkTelemetry* telemetry_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKNEWTONSOLVER_H */
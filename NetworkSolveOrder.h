@@ -0,0 +1,226 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKSOLVEORDER_H
+#define NETSMOKE_NETWORKSOLVEORDER_H
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "NetworkTopology.h"
+
+namespace NetSMOKE
+{
+	//!  Sequential-modular solve order of the reactor network
+	/*!
+		 The units are grouped in blocks, i.e. the strongly connected components of the
+		 unit graph (Tarjan's algorithm, iterative to cope with long reactor chains).
+		 The blocks are stored in topological order of the condensation DAG: solving them
+		 one after the other, every block finds its inlet streams already computed.
+		 Only recycle blocks (more than one unit, or a unit feeding itself) need to be
+		 iterated, all the others are solved once.
+	*/
+	class NetworkSolveOrder
+	{
+	public:
+
+		NetworkSolveOrder() : number_of_blocks_(0) {}
+
+		void Analyze(const NetworkTopology& topology)
+		{
+			const unsigned int n = topology.NumberOfUnits();
+			const std::vector<unsigned int>& ptr = topology.SuccessorPtr();
+			const std::vector<unsigned int>& adj = topology.Successors();
+
+			const int unvisited = -1;
+			std::vector<int> index(n, unvisited);
+			std::vector<int> lowlink(n, 0);
+			std::vector<bool> on_stack(n, false);
+			std::vector<unsigned int> stack;
+			std::vector< std::pair<unsigned int, unsigned int> > call_stack;	// (unit, next successor position)
+			int counter = 0;
+
+			// Blocks are found in reverse topological order
+			std::vector< std::vector<unsigned int> > blocks;
+
+			for (unsigned int root = 0; root < n; root++)
+			{
+				if (index[root] != unvisited)
+					continue;
+
+				call_stack.push_back(std::make_pair(root, ptr[root]));
+				index[root] = lowlink[root] = counter++;
+				stack.push_back(root);
+				on_stack[root] = true;
+
+				while (call_stack.empty() == false)
+				{
+					const unsigned int v = call_stack.back().first;
+					unsigned int& j = call_stack.back().second;
+
+					if (j < ptr[v + 1])
+					{
+						const unsigned int w = adj[j++];
+						if (index[w] == unvisited)
+						{
+							index[w] = lowlink[w] = counter++;
+							stack.push_back(w);
+							on_stack[w] = true;
+							call_stack.push_back(std::make_pair(w, ptr[w]));
+						}
+						else if (on_stack[w] == true)
+							lowlink[v] = std::min(lowlink[v], index[w]);
+					}
+					else
+					{
+						call_stack.pop_back();
+						if (call_stack.empty() == false)
+						{
+							const unsigned int u = call_stack.back().first;
+							lowlink[u] = std::min(lowlink[u], lowlink[v]);
+						}
+
+						if (lowlink[v] == index[v])
+						{
+							std::vector<unsigned int> block;
+							unsigned int w;
+							do
+							{
+								w = stack.back();
+								stack.pop_back();
+								on_stack[w] = false;
+								block.push_back(w);
+							} while (w != v);
+							std::sort(block.begin(), block.end());
+							blocks.push_back(block);
+						}
+					}
+				}
+			}
+
+			number_of_blocks_ = static_cast<unsigned int>(blocks.size());
+			block_ptr_.assign(number_of_blocks_ + 1, 0);
+			block_units_.clear();
+			block_units_.reserve(n);
+			unit_block_.resize(n);
+			is_recycle_.resize(number_of_blocks_);
+
+			for (unsigned int b = 0; b < number_of_blocks_; b++)
+			{
+				const std::vector<unsigned int>& block = blocks[number_of_blocks_ - 1 - b];
+				for (unsigned int k = 0; k < block.size(); k++)
+					unit_block_[block[k]] = b;
+				block_units_.insert(block_units_.end(), block.begin(), block.end());
+				block_ptr_[b + 1] = static_cast<unsigned int>(block_units_.size());
+			}
+
+			for (unsigned int b = 0; b < number_of_blocks_; b++)
+			{
+				is_recycle_[b] = (block_ptr_[b + 1] - block_ptr_[b] > 1);
+				if (is_recycle_[b] == false)
+				{
+					const unsigned int v = block_units_[block_ptr_[b]];
+					for (unsigned int j = ptr[v]; j < ptr[v + 1]; j++)
+						if (adj[j] == v)	is_recycle_[b] = true;
+				}
+			}
+
+			BuildCondensation(topology);
+		}
+
+		unsigned int NumberOfBlocks() const { return number_of_blocks_; }
+
+		//! Units of each block (CSR), blocks in topological order
+		const std::vector<unsigned int>& BlockPtr() const { return block_ptr_; }
+		const std::vector<unsigned int>& BlockUnits() const { return block_units_; }
+
+		//! Block containing each unit
+		const std::vector<unsigned int>& UnitBlock() const { return unit_block_; }
+
+		//! True if the block contains a recycle and must be iterated
+		bool IsRecycle(const unsigned int b) const { return is_recycle_[b]; }
+
+		//! Downstream/upstream blocks in the condensation DAG (CSR)
+		const std::vector<unsigned int>& BlockSuccessorPtr() const { return block_successor_ptr_; }
+		const std::vector<unsigned int>& BlockSuccessors() const { return block_successors_; }
+		const std::vector<unsigned int>& BlockPredecessorPtr() const { return block_predecessor_ptr_; }
+		const std::vector<unsigned int>& BlockPredecessors() const { return block_predecessors_; }
+
+		void Summary(std::ostream& out, const NetworkTopology& topology) const
+		{
+			unsigned int n_recycles = 0;
+			unsigned int n_recycle_units = 0;
+			for (unsigned int b = 0; b < number_of_blocks_; b++)
+				if (is_recycle_[b] == true)
+				{
+					n_recycles++;
+					n_recycle_units += block_ptr_[b + 1] - block_ptr_[b];
+				}
+
+			out << std::endl;
+			out << "Network topology analysis" << std::endl;
+			out << " * Units:                " << topology.NumberOfUnits() << std::endl;
+			out << " * Streams:              " << topology.NumberOfStreams() << std::endl;
+			out << " * Blocks:               " << number_of_blocks_ << std::endl;
+			out << " * Recycle blocks:       " << n_recycles << std::endl;
+			out << " * Units in recycles:    " << n_recycle_units << std::endl;
+			out << std::endl;
+		}
+
+	private:
+
+		void BuildCondensation(const NetworkTopology& topology)
+		{
+			const std::vector<unsigned int>& ptr = topology.SuccessorPtr();
+			const std::vector<unsigned int>& adj = topology.Successors();
+
+			std::vector< std::vector<unsigned int> > successors(number_of_blocks_);
+			std::vector< std::vector<unsigned int> > predecessors(number_of_blocks_);
+			for (unsigned int v = 0; v < topology.NumberOfUnits(); v++)
+				for (unsigned int j = ptr[v]; j < ptr[v + 1]; j++)
+				{
+					const unsigned int a = unit_block_[v];
+					const unsigned int b = unit_block_[adj[j]];
+					if (a != b)
+					{
+						successors[a].push_back(b);
+						predecessors[b].push_back(a);
+					}
+				}
+
+			FlattenAdjacency(successors, block_successor_ptr_, block_successors_);
+			FlattenAdjacency(predecessors, block_predecessor_ptr_, block_predecessors_);
+		}
+
+	private:
+
+		unsigned int number_of_blocks_;
+
+		std::vector<unsigned int> block_ptr_;
+		std::vector<unsigned int> block_units_;
+		std::vector<unsigned int> unit_block_;
+		std::vector<bool> is_recycle_;
+
+		std::vector<unsigned int> block_successor_ptr_;
+		std::vector<unsigned int> block_successors_;
+		std::vector<unsigned int> block_predecessor_ptr_;
+		std::vector<unsigned int> block_predecessors_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKSOLVEORDER_H */
@@ -0,0 +1,95 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKTASKSCHEDULER_H
+#define NETSMOKE_NETWORKTASKSCHEDULER_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include "NetworkSolveOrder.h"
+#include "WorkStealingThreadPool.h"
+
+namespace NetSMOKE
+{
+	//!  Dataflow execution of the network blocks
+	/*!
+		 Every block of the solve order (a single PSR/PFR/mixer/splitter, or a whole recycle)
+		 is launched as a task as soon as all the blocks producing its inlet streams are done.
+		 Independent branches of the network are therefore solved concurrently.
+	*/
+	class NetworkTaskScheduler
+	{
+	public:
+
+		explicit NetworkTaskScheduler(const NetworkSolveOrder& order) :
+			order_(order),
+			number_of_blocks_(order.NumberOfBlocks()),
+			remaining_(new std::atomic<unsigned int>[order.NumberOfBlocks()])
+		{
+		}
+
+		//! Solves the network calling solve_block(b) for every block b
+		template<typename BlockSolver>
+		void Run(WorkStealingThreadPool& pool, BlockSolver& solve_block)
+		{
+			const std::vector<unsigned int>& ptr = order_.BlockPredecessorPtr();
+			for (unsigned int b = 0; b < number_of_blocks_; b++)
+				remaining_[b] = ptr[b + 1] - ptr[b];
+
+			// With a single thread the topological order is already optimal
+			if (pool.NumberOfThreads() == 1)
+			{
+				for (unsigned int b = 0; b < number_of_blocks_; b++)
+					solve_block(b);
+				return;
+			}
+
+			for (unsigned int b = 0; b < number_of_blocks_; b++)
+				if (ptr[b + 1] == ptr[b])
+					Launch(pool, solve_block, b);
+
+			pool.WaitAll();
+		}
+
+	private:
+
+		template<typename BlockSolver>
+		void Launch(WorkStealingThreadPool& pool, BlockSolver& solve_block, const unsigned int b)
+		{
+			pool.Submit([this, &pool, &solve_block, b]()
+			{
+				solve_block(b);
+
+				const std::vector<unsigned int>& ptr = order_.BlockSuccessorPtr();
+				const std::vector<unsigned int>& successors = order_.BlockSuccessors();
+				for (unsigned int j = ptr[b]; j < ptr[b + 1]; j++)
+					if (--remaining_[successors[j]] == 0)
+						Launch(pool, solve_block, successors[j]);
+			});
+		}
+
+	private:
+
+		const NetworkSolveOrder& order_;
+		unsigned int number_of_blocks_;
+		std::unique_ptr< std::atomic<unsigned int>[] > remaining_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKTASKSCHEDULER_H */
@@ -0,0 +1,454 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKTELEMETRY_H
+#define NETSMOKE_NETWORKTELEMETRY_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stdint.h>
+#include "boost/filesystem.hpp"
+#include "NetworkTopology.h"
+#include "NetworkSolveOrder.h"
+
+namespace NetSMOKE
+{
+	//! Counters of a single unit
+	struct UnitCounters
+	{
+		UnitCounters() : wall_time(0.), calls(0), newton_iterations(0), jacobian_evaluations(0), jacobian_reuses(0), factorizations(0), factorization_reuses(0), ode_steps(0), failures(0) {}
+
+		double wall_time;					// [s]
+		uint64_t calls;
+		uint64_t newton_iterations;
+		uint64_t jacobian_evaluations;
+		uint64_t jacobian_reuses;			// Newton iterations with an older Jacobian (aged, from the cache or from a similar reactor)
+		uint64_t factorizations;
+		uint64_t factorization_reuses;		// Newton iterations solved with an older factorization
+		uint64_t ode_steps;
+		uint64_t failures;
+
+		void Add(const UnitCounters& other)
+		{
+			wall_time += other.wall_time;
+			calls += other.calls;
+			newton_iterations += other.newton_iterations;
+			jacobian_evaluations += other.jacobian_evaluations;
+			jacobian_reuses += other.jacobian_reuses;
+			factorizations += other.factorizations;
+			factorization_reuses += other.factorization_reuses;
+			ode_steps += other.ode_steps;
+			failures += other.failures;
+		}
+	};
+
+	//!  Per-unit and per-recycle-block solver statistics
+	/*!
+		 Every thread updates its own copy of the unit counters (allocated the first time the
+		 thread reports something), so that the hot path does not need any synchronization;
+		 the copies are summed by Aggregate() at the end of the run. The residual history of a
+		 recycle block is written only by the thread solving that block.
+		 Optionally every call of a unit is recorded as a complete event ("ph":"X") of the Chrome
+		 trace format (chrome://tracing, Perfetto).
+		 The solvers report to the telemetry set with their SetTelemetry (none by default): the
+		 PSR, mixer and PFR solvers per unit, ConvergeRecycle per recycle block, the global Newton
+		 solver in the network counters and the ParameterSweep per case.
+
+		 Usage:
+			{
+				NetworkTelemetry::ScopedUnitTimer timer(telemetry, k);
+				... solve unit k ...
+				telemetry.Local(k).newton_iterations += n;
+			}
+	*/
+	class NetworkTelemetry
+	{
+	public:
+
+		NetworkTelemetry(const NetworkTopology& topology, const NetworkSolveOrder& order, const bool trace) :
+			topology_(topology),
+			order_(order),
+			trace_(trace),
+			id_(NextId()++),
+			start_(std::chrono::steady_clock::now())
+		{
+			recycle_residuals_.resize(order.NumberOfBlocks());
+		}
+
+		//! Counters of unit k for the calling thread
+		UnitCounters& Local(const unsigned int k)
+		{
+			return LocalData().counters[k];
+		}
+
+		//! Residual of a new iteration of recycle block b
+		void RecordRecycleIteration(const unsigned int b, const double residual)
+		{
+			recycle_residuals_[b].push_back(residual);
+		}
+
+		//! Counters of the global Newton solver of the network (written by the thread solving it)
+		UnitCounters& Network() { return network_; }
+		const UnitCounters& Network() const { return network_; }
+
+		//! Residual norm of a new iteration of the global Newton solver
+		void RecordNetworkIteration(const double residual)
+		{
+			network_residuals_.push_back(residual);
+		}
+
+		const std::vector<double>& NetworkResiduals() const { return network_residuals_; }
+
+		//! Result of case k of a ParameterSweep (warm_start_from = -1 for a cold start)
+		void RecordSweepCase(const unsigned int k, const double wall_time, const bool converged, const int warm_start_from)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (sweep_cases_.size() <= k)
+				sweep_cases_.resize(k + 1);
+			sweep_cases_[k].wall_time = wall_time;
+			sweep_cases_[k].converged = converged;
+			sweep_cases_[k].warm_start_from = warm_start_from;
+		}
+
+		//! Wall time and number of calls of a unit (and trace event, if enabled); nothing if the telemetry is null
+		class ScopedUnitTimer
+		{
+		public:
+
+			ScopedUnitTimer(NetworkTelemetry& telemetry, const unsigned int k) :
+				telemetry_(&telemetry),
+				unit_(k),
+				begin_(std::chrono::steady_clock::now())
+			{
+			}
+
+			ScopedUnitTimer(NetworkTelemetry* telemetry, const unsigned int k) :
+				telemetry_(telemetry),
+				unit_(k)
+			{
+				if (telemetry_ != nullptr)
+					begin_ = std::chrono::steady_clock::now();
+			}
+
+			~ScopedUnitTimer()
+			{
+				if (telemetry_ == nullptr)
+					return;
+
+				const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+				ThreadData& data = telemetry_->LocalData();
+				UnitCounters& counters = data.counters[unit_];
+				counters.wall_time += std::chrono::duration<double>(end - begin_).count();
+				counters.calls++;
+
+				if (telemetry_->trace_ == true)
+				{
+					TraceEvent event;
+					event.unit = unit_;
+					event.begin = std::chrono::duration<double, std::micro>(begin_ - telemetry_->start_).count();
+					event.duration = std::chrono::duration<double, std::micro>(end - begin_).count();
+					data.events.push_back(event);
+				}
+			}
+
+		private:
+
+			NetworkTelemetry* telemetry_;
+			unsigned int unit_;
+			std::chrono::steady_clock::time_point begin_;
+		};
+
+		//! Sums the counters of all the threads (to be called when no unit is being solved)
+		void Aggregate()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			totals_.assign(topology_.NumberOfUnits(), UnitCounters());
+			for (unsigned int t = 0; t < threads_.size(); t++)
+				for (unsigned int k = 0; k < totals_.size(); k++)
+					totals_[k].Add(threads_[t]->counters[k]);
+		}
+
+		const std::vector<UnitCounters>& Totals() const { return totals_; }
+		const std::vector<double>& RecycleResiduals(const unsigned int b) const { return recycle_residuals_[b]; }
+
+		//! The n units with the largest wall time
+		void Summary(std::ostream& out, const unsigned int n) const
+		{
+			std::vector<unsigned int> units(totals_.size());
+			for (unsigned int k = 0; k < units.size(); k++)
+				units[k] = k;
+			const unsigned int m = std::min(n, static_cast<unsigned int>(units.size()));
+			std::partial_sort(units.begin(), units.begin() + m, units.end(), WallTimeGreater(totals_));
+
+			double total = 0.;
+			for (unsigned int k = 0; k < totals_.size(); k++)
+				total += totals_[k].wall_time;
+
+			out << std::endl;
+			out << "Most expensive units (total " << total << " s)" << std::endl;
+			for (unsigned int i = 0; i < m; i++)
+			{
+				const UnitCounters& c = totals_[units[i]];
+				out << " * " << std::left << std::setw(24) << topology_.UnitNames()[units[i]] << std::right
+					<< std::setw(12) << c.wall_time << " s  " << std::setw(6) << std::fixed << std::setprecision(2)
+					<< (total > 0. ? 100. * c.wall_time / total : 0.) << "%  calls " << c.calls
+					<< "  failures " << c.failures << std::endl;
+				out.unsetf(std::ios::fixed);
+				out << std::setprecision(6);
+			}
+
+			UnitCounters sum;
+			for (unsigned int k = 0; k < totals_.size(); k++)
+				sum.Add(totals_[k]);
+			if (sum.jacobian_reuses + sum.factorization_reuses > 0)
+			{
+				const double jacobians = static_cast<double>(sum.jacobian_evaluations + sum.jacobian_reuses);
+				const double solves = static_cast<double>(sum.factorizations + sum.factorization_reuses);
+				out << "Jacobian reuse " << std::fixed << std::setprecision(2)
+					<< (jacobians > 0. ? 100. * sum.jacobian_reuses / jacobians : 0.) << "%  factorization reuse "
+					<< (solves > 0. ? 100. * sum.factorization_reuses / solves : 0.) << "%" << std::endl;
+				out.unsetf(std::ios::fixed);
+				out << std::setprecision(6);
+			}
+			out << std::endl;
+		}
+
+		void WriteCSV(const boost::filesystem::path& file_name) const
+		{
+			std::ofstream fOutput(file_name.c_str(), std::ios::out);
+			if (!fOutput.is_open())
+				OpenSMOKE::FatalErrorMessage("Unable to write the telemetry file: " + file_name.string());
+
+			fOutput << "unit,type,block,wall_time_s,calls,newton_iterations,jacobian_evaluations,jacobian_reuses,factorizations,factorization_reuses,ode_steps,failures" << std::endl;
+			fOutput << std::setprecision(9);
+			for (unsigned int k = 0; k < totals_.size(); k++)
+			{
+				const UnitCounters& c = totals_[k];
+				fOutput << topology_.UnitNames()[k] << "," << UnitTypeName(topology_.Type()[k]) << "," << order_.UnitBlock()[k] << ","
+						<< c.wall_time << "," << c.calls << "," << c.newton_iterations << "," << c.jacobian_evaluations << ","
+						<< c.jacobian_reuses << "," << c.factorizations << "," << c.factorization_reuses << ","
+						<< c.ode_steps << "," << c.failures << std::endl;
+			}
+
+			// Global Newton solver of the whole network, if used
+			if (network_.newton_iterations > 0 || network_.failures > 0)
+			{
+				const UnitCounters& c = network_;
+				fOutput << "network,Network,-1," << c.wall_time << "," << c.calls << "," << c.newton_iterations << "," << c.jacobian_evaluations << ","
+						<< c.jacobian_reuses << "," << c.factorizations << "," << c.factorization_reuses << ","
+						<< c.ode_steps << "," << c.failures << std::endl;
+			}
+		}
+
+		void WriteJSON(const boost::filesystem::path& file_name) const
+		{
+			std::ofstream fOutput(file_name.c_str(), std::ios::out);
+			if (!fOutput.is_open())
+				OpenSMOKE::FatalErrorMessage("Unable to write the telemetry file: " + file_name.string());
+
+			fOutput << std::setprecision(9);
+			fOutput << "{" << std::endl;
+			fOutput << "  \"units\": [" << std::endl;
+			for (unsigned int k = 0; k < totals_.size(); k++)
+			{
+				const UnitCounters& c = totals_[k];
+				fOutput << "    {\"name\": \"" << JSONEscape(topology_.UnitNames()[k]) << "\", \"type\": \"" << UnitTypeName(topology_.Type()[k])
+						<< "\", \"block\": " << order_.UnitBlock()[k] << ", \"wall_time\": " << c.wall_time << ", \"calls\": " << c.calls
+						<< ", \"newton_iterations\": " << c.newton_iterations << ", \"jacobian_evaluations\": " << c.jacobian_evaluations
+						<< ", \"jacobian_reuses\": " << c.jacobian_reuses << ", \"factorizations\": " << c.factorizations
+						<< ", \"factorization_reuses\": " << c.factorization_reuses << ", \"ode_steps\": " << c.ode_steps << ", \"failures\": " << c.failures << "}"
+						<< (k + 1 < totals_.size() ? "," : "") << std::endl;
+			}
+			fOutput << "  ]," << std::endl;
+
+			fOutput << "  \"recycle_blocks\": [" << std::endl;
+			bool first = true;
+			for (unsigned int b = 0; b < order_.NumberOfBlocks(); b++)
+			{
+				if (order_.IsRecycle(b) == false)
+					continue;
+				fOutput << (first ? "" : ",\n") << "    {\"block\": " << b << ", \"units\": " << order_.BlockPtr()[b + 1] - order_.BlockPtr()[b]
+						<< ", \"iterations\": " << recycle_residuals_[b].size() << ", \"residuals\": [";
+				for (unsigned int i = 0; i < recycle_residuals_[b].size(); i++)
+					fOutput << (i > 0 ? ", " : "") << recycle_residuals_[b][i];
+				fOutput << "]}";
+				first = false;
+			}
+			fOutput << (first ? "" : "\n") << "  ]," << std::endl;
+
+			fOutput << "  \"network\": {\"wall_time\": " << network_.wall_time << ", \"calls\": " << network_.calls
+					<< ", \"newton_iterations\": " << network_.newton_iterations << ", \"jacobian_evaluations\": " << network_.jacobian_evaluations
+					<< ", \"factorizations\": " << network_.factorizations << ", \"failures\": " << network_.failures << ", \"residuals\": [";
+			for (unsigned int i = 0; i < network_residuals_.size(); i++)
+				fOutput << (i > 0 ? ", " : "") << network_residuals_[i];
+			fOutput << "]}," << std::endl;
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			fOutput << "  \"sweep_cases\": [" << std::endl;
+			for (unsigned int k = 0; k < sweep_cases_.size(); k++)
+				fOutput << "    {\"case\": " << k << ", \"wall_time\": " << sweep_cases_[k].wall_time << ", \"converged\": "
+						<< (sweep_cases_[k].converged ? "true" : "false") << ", \"warm_start_from\": " << sweep_cases_[k].warm_start_from << "}"
+						<< (k + 1 < sweep_cases_.size() ? "," : "") << std::endl;
+			fOutput << "  ]" << std::endl;
+			fOutput << "}" << std::endl;
+		}
+
+		//! Trace events of all the threads (requires trace enabled in the constructor)
+		void WriteChromeTrace(const boost::filesystem::path& file_name) const
+		{
+			std::ofstream fOutput(file_name.c_str(), std::ios::out);
+			if (!fOutput.is_open())
+				OpenSMOKE::FatalErrorMessage("Unable to write the trace file: " + file_name.string());
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			fOutput << std::fixed << std::setprecision(3);
+			fOutput << "{\"traceEvents\": [" << std::endl;
+			bool first = true;
+			for (unsigned int t = 0; t < threads_.size(); t++)
+				for (unsigned int i = 0; i < threads_[t]->events.size(); i++)
+				{
+					const TraceEvent& event = threads_[t]->events[i];
+					fOutput << (first ? "" : ",\n") << "{\"name\": \"" << JSONEscape(topology_.UnitNames()[event.unit])
+							<< "\", \"cat\": \"" << UnitTypeName(topology_.Type()[event.unit]) << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << t
+							<< ", \"ts\": " << event.begin << ", \"dur\": " << event.duration << "}";
+					first = false;
+				}
+			fOutput << std::endl << "]}" << std::endl;
+		}
+
+		static const char* UnitTypeName(const UnitType type)
+		{
+			switch (type)
+			{
+				case UNIT_PSR:				return "PSR";
+				case UNIT_PFR:				return "PFR";
+				case UNIT_MIXER:			return "Mixer";
+				case UNIT_SPLITTER:			return "Splitter";
+				case UNIT_PHASESPLITTER:	return "PhaseSplitter";
+			}
+			return "Unknown";
+		}
+
+	private:
+
+		struct TraceEvent
+		{
+			unsigned int unit;
+			double begin;		// [us] from the construction of the telemetry
+			double duration;	// [us]
+		};
+
+		struct SweepCaseRecord
+		{
+			SweepCaseRecord() : wall_time(0.), converged(false), warm_start_from(-1) {}
+
+			double wall_time;	// [s]
+			bool converged;
+			int warm_start_from;
+		};
+
+		struct ThreadData
+		{
+			std::thread::id thread;
+			std::vector<UnitCounters> counters;
+			std::vector<TraceEvent> events;
+		};
+
+		struct WallTimeGreater
+		{
+			explicit WallTimeGreater(const std::vector<UnitCounters>& totals) : totals_(totals) {}
+			bool operator()(const unsigned int a, const unsigned int b) const { return totals_[a].wall_time > totals_[b].wall_time; }
+			const std::vector<UnitCounters>& totals_;
+		};
+
+		//! Data of the calling thread
+		/*!
+			 The thread caches the data of the last telemetry it used (a comparison with the cached
+			 owner); when it switches between instances the data is looked up by thread id, so
+			 every thread has a single entry per telemetry.
+		*/
+		ThreadData& LocalData()
+		{
+			static thread_local uint64_t owner = 0;
+			static thread_local ThreadData* data = nullptr;
+			if (owner != id_)
+			{
+				const std::thread::id thread = std::this_thread::get_id();
+				std::lock_guard<std::mutex> lock(mutex_);
+				data = nullptr;
+				for (unsigned int t = 0; t < threads_.size() && data == nullptr; t++)
+					if (threads_[t]->thread == thread)
+						data = threads_[t].get();
+				if (data == nullptr)
+				{
+					threads_.push_back(std::unique_ptr<ThreadData>(new ThreadData()));
+					threads_.back()->thread = thread;
+					threads_.back()->counters.resize(topology_.NumberOfUnits());
+					data = threads_.back().get();
+				}
+				owner = id_;
+			}
+			return *data;
+		}
+
+		static std::atomic<uint64_t>& NextId()
+		{
+			static std::atomic<uint64_t> id(1);
+			return id;
+		}
+
+		static std::string JSONEscape(const std::string& text)
+		{
+			std::string escaped;
+			for (unsigned int i = 0; i < text.size(); i++)
+			{
+				if (text[i] == '"' || text[i] == '\\')
+					escaped += '\\';
+				escaped += text[i];
+			}
+			return escaped;
+		}
+
+	private:
+
+		const NetworkTopology& topology_;
+		const NetworkSolveOrder& order_;
+		bool trace_;
+		uint64_t id_;
+		std::chrono::steady_clock::time_point start_;
+
+		mutable std::mutex mutex_;
+		std::vector< std::unique_ptr<ThreadData> > threads_;
+		std::vector<UnitCounters> totals_;
+		std::vector< std::vector<double> > recycle_residuals_;
+		UnitCounters network_;
+		std::vector<double> network_residuals_;
+		std::vector<SweepCaseRecord> sweep_cases_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKTELEMETRY_H */
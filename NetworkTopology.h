@@ -0,0 +1,348 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_NETWORKTOPOLOGY_H
+#define NETSMOKE_NETWORKTOPOLOGY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "dictionary/OpenSMOKE_Dictionary.h"
+#include "Grammar_NetSMOKE_ReactorBlocks.h"
+
+namespace NetSMOKE
+{
+	enum UnitType { UNIT_PSR, UNIT_PFR, UNIT_MIXER, UNIT_SPLITTER, UNIT_PHASESPLITTER };
+	enum EnergyType { ENERGY_NONE, ENERGY_ISOTHERMAL, ENERGY_ADIABATIC, ENERGY_HEATEXCHANGE };
+	enum PhaseType { PHASE_GAS, PHASE_MIX, PHASE_SOLID, PHASE_LIQUID };
+
+	// Producer/consumer of a stream which enters or leaves the network
+	const int NoUnit = -1;
+
+	inline UnitType UnitTypeFromString(const std::string& tag)
+	{
+		if (tag == "PSR")								return UNIT_PSR;
+		else if (tag == "PFR")							return UNIT_PFR;
+		else if (tag == "Mixer")						return UNIT_MIXER;
+		else if (tag == "Splitter")						return UNIT_SPLITTER;
+		else if (tag == "PhaseSplitter")				return UNIT_PHASESPLITTER;
+		else OpenSMOKE::FatalErrorMessage("Unknown unit type: " + tag + " (use PSR, PFR, Mixer, Splitter, PhaseSplitter)");
+		return UNIT_PSR;
+	}
+
+	inline EnergyType EnergyTypeFromString(const std::string& energy)
+	{
+		if (energy == "")												return ENERGY_NONE;
+		else if (energy == "Isothermal")								return ENERGY_ISOTHERMAL;
+		else if (energy == "Adiabatic")									return ENERGY_ADIABATIC;
+		else if (energy == "HeatExchange" || energy == "HeatExchanger")	return ENERGY_HEATEXCHANGE;
+		else OpenSMOKE::FatalErrorMessage("Unknown energy type: " + energy + " (use Isothermal, Adiabatic, HeatExchange)");
+		return ENERGY_NONE;
+	}
+
+	inline PhaseType PhaseTypeFromString(const std::string& phase)
+	{
+		if (phase == "Gas")				return PHASE_GAS;
+		else if (phase == "Mix")		return PHASE_MIX;
+		else if (phase == "Solid")		return PHASE_SOLID;
+		else if (phase == "Liquid")		return PHASE_LIQUID;
+		else OpenSMOKE::FatalErrorMessage("Unknown phase: " + phase + " (use Gas, Mix, Solid, Liquid)");
+		return PHASE_GAS;
+	}
+
+	//! Sorts, removes duplicates and stores a list of adjacency lists in CSR format
+	inline void FlattenAdjacency(std::vector< std::vector<unsigned int> >& lists, std::vector<unsigned int>& ptr, std::vector<unsigned int>& indices)
+	{
+		ptr.assign(lists.size() + 1, 0);
+		indices.clear();
+		for (unsigned int k = 0; k < lists.size(); k++)
+		{
+			std::sort(lists[k].begin(), lists[k].end());
+			lists[k].erase(std::unique(lists[k].begin(), lists[k].end()), lists[k].end());
+			indices.insert(indices.end(), lists[k].begin(), lists[k].end());
+			ptr[k + 1] = static_cast<unsigned int>(indices.size());
+		}
+	}
+
+	//!  Compiled representation of the reactor network
+	/*!
+		 Units and streams are renumbered with dense indices (0-based, in declaration order for
+		 the units and in order of first appearance for the streams). The unit-stream adjacency
+		 is stored in compressed sparse row format, the unit properties as structure of arrays.
+		 The string-based UnitInfo records are needed only during the compilation.
+	*/
+	class NetworkTopology
+	{
+		friend class NetworkCache;
+
+	public:
+
+		NetworkTopology() : number_of_units_(0), number_of_streams_(0) {}
+
+		//! Compiles the list of units read from the input dictionaries
+		void Compile(const std::vector<NetSMOKE::UnitInfo>& UnitsData)
+		{
+			Compile(UnitsData, std::vector<NetSMOKE::ReactorBlock>());
+		}
+
+		//! Compiles the units read from the input dictionaries followed by the bulk reactor blocks
+		void Compile(const std::vector<NetSMOKE::UnitInfo>& UnitsData, const std::vector<NetSMOKE::ReactorBlock>& ReactorBlocks)
+		{
+			number_of_units_ = static_cast<unsigned int>(UnitsData.size());
+			for (unsigned int b = 0; b < ReactorBlocks.size(); b++)
+				number_of_units_ += ReactorBlocks[b].NumberOfReactors();
+			number_of_streams_ = 0;
+
+			unit_names_.resize(number_of_units_);
+			unit_type_.resize(number_of_units_);
+			unit_energy_.resize(number_of_units_);
+			volume_.resize(number_of_units_);
+			residence_time_.resize(number_of_units_);
+			UA_.resize(number_of_units_);
+			temperature_.resize(number_of_units_);
+			pressure_.resize(number_of_units_);
+			diameter_.resize(number_of_units_);
+			length_.resize(number_of_units_);
+
+			stream_ids_.clear();
+			stream_source_.clear();
+			stream_target_.clear();
+			stream_phase_.clear();
+			stream_mass_flow_.clear();
+			stream_index_.clear();
+
+			inlet_ptr_.assign(number_of_units_ + 1, 0);
+			outlet_ptr_.assign(number_of_units_ + 1, 0);
+			for (unsigned int k = 0; k < UnitsData.size(); k++)
+			{
+				inlet_ptr_[k + 1] = inlet_ptr_[k] + static_cast<unsigned int>(UnitsData[k].inlets.size());
+				outlet_ptr_[k + 1] = outlet_ptr_[k] + static_cast<unsigned int>(UnitsData[k].outlets.size());
+			}
+			for (unsigned int b = 0, k = static_cast<unsigned int>(UnitsData.size()); b < ReactorBlocks.size(); b++)
+				for (unsigned int i = 0; i < ReactorBlocks[b].NumberOfReactors(); i++, k++)
+				{
+					inlet_ptr_[k + 1] = inlet_ptr_[k] + ReactorBlocks[b].inlet_ptr[i + 1] - ReactorBlocks[b].inlet_ptr[i];
+					outlet_ptr_[k + 1] = outlet_ptr_[k] + ReactorBlocks[b].outlet_ptr[i + 1] - ReactorBlocks[b].outlet_ptr[i];
+				}
+			inlet_streams_.resize(inlet_ptr_[number_of_units_]);
+			outlet_streams_.resize(outlet_ptr_[number_of_units_]);
+
+			for (unsigned int k = 0; k < UnitsData.size(); k++)
+			{
+				const NetSMOKE::UnitInfo& unit = UnitsData[k];
+
+				unit_names_[k] = unit.name;
+				unit_type_[k] = UnitTypeFromString(unit.tag);
+				unit_energy_[k] = EnergyTypeFromString(unit.energy);
+				volume_[k] = unit.volume;
+				residence_time_[k] = unit.residence_time;
+				UA_[k] = unit.UA;
+				temperature_[k] = unit.temperature;
+				pressure_[k] = unit.pressure;
+				diameter_[k] = unit.diameter;
+				length_[k] = unit.length;
+
+				for (unsigned int j = 0; j < unit.inlets.size(); j++)
+					LinkInlet(k, j, unit.inlets[j]);
+
+				if (unit_type_[k] == UNIT_PHASESPLITTER && unit.outlet_phase.size() != unit.outlets.size())
+					OpenSMOKE::FatalErrorMessage("OutletPhase and OutletStream of phase splitter " + unit.name + " must have the same length");
+
+				for (unsigned int j = 0; j < unit.outlets.size(); j++)
+				{
+					const unsigned int s = LinkOutlet(k, j, unit.outlets[j]);
+					if (unit_type_[k] == UNIT_PHASESPLITTER)
+						stream_phase_[s] = PhaseTypeFromString(unit.outlet_phase[j]);
+				}
+			}
+
+			for (unsigned int b = 0, k = static_cast<unsigned int>(UnitsData.size()); b < ReactorBlocks.size(); b++)
+			{
+				const NetSMOKE::ReactorBlock& block = ReactorBlocks[b];
+				const UnitType type = UnitTypeFromString(block.tag);
+				const EnergyType energy = EnergyTypeFromString(block.energy);
+
+				for (unsigned int i = 0; i < block.NumberOfReactors(); i++, k++)
+				{
+					unit_names_[k] = block.name + "_" + std::to_string(i);
+					unit_type_[k] = type;
+					unit_energy_[k] = energy;
+					volume_[k] = block.volume[i];
+					residence_time_[k] = -1;
+					UA_[k] = 0.;
+					temperature_[k] = block.temperature[i];
+					pressure_[k] = block.pressure[i];
+					diameter_[k] = -1;
+					length_[k] = -1;
+
+					for (unsigned int j = block.inlet_ptr[i]; j < block.inlet_ptr[i + 1]; j++)
+						LinkInlet(k, j - block.inlet_ptr[i], block.inlet_ids[j]);
+					for (unsigned int j = block.outlet_ptr[i]; j < block.outlet_ptr[i + 1]; j++)
+						LinkOutlet(k, j - block.outlet_ptr[i], block.outlet_ids[j]);
+				}
+
+				for (unsigned int j = 0; j < block.flow_ids.size(); j++)
+					stream_mass_flow_[IndexOfStream(block.flow_ids[j])] = block.flow_rates[j];
+			}
+
+			BuildUnitGraph();
+		}
+
+		unsigned int NumberOfUnits() const { return number_of_units_; }
+		unsigned int NumberOfStreams() const { return number_of_streams_; }
+
+		//! Dense index of the stream with the given ID (as declared in InletStream/OutletStream)
+		unsigned int IndexOfStream(const int id) const
+		{
+			std::map<int, unsigned int>::const_iterator it = stream_index_.find(id);
+			if (it == stream_index_.end())
+				OpenSMOKE::FatalErrorMessage("Stream " + std::to_string(id) + " is not defined in the network");
+			return it->second;
+		}
+
+		// Unit -> stream adjacency (CSR)
+		const std::vector<unsigned int>& InletPtr() const { return inlet_ptr_; }
+		const std::vector<unsigned int>& InletStreams() const { return inlet_streams_; }
+		const std::vector<unsigned int>& OutletPtr() const { return outlet_ptr_; }
+		const std::vector<unsigned int>& OutletStreams() const { return outlet_streams_; }
+
+		// Stream -> unit adjacency (NoUnit for network inlets/outlets)
+		const std::vector<int>& StreamSource() const { return stream_source_; }
+		const std::vector<int>& StreamTarget() const { return stream_target_; }
+		const std::vector<int>& StreamIDs() const { return stream_ids_; }
+		const std::vector<PhaseType>& StreamPhase() const { return stream_phase_; }
+
+		//! Mass flow rate (kg/s) given in input for the stream (-1 if not available)
+		const std::vector<double>& StreamMassFlow() const { return stream_mass_flow_; }
+
+		// Unit -> downstream/upstream units (CSR, duplicates removed)
+		const std::vector<unsigned int>& SuccessorPtr() const { return successor_ptr_; }
+		const std::vector<unsigned int>& Successors() const { return successors_; }
+		const std::vector<unsigned int>& PredecessorPtr() const { return predecessor_ptr_; }
+		const std::vector<unsigned int>& Predecessors() const { return predecessors_; }
+
+		// Unit properties (SI units)
+		const std::vector<std::string>& UnitNames() const { return unit_names_; }
+		const std::vector<UnitType>& Type() const { return unit_type_; }
+		const std::vector<EnergyType>& Energy() const { return unit_energy_; }
+		const std::vector<double>& Volume() const { return volume_; }
+		const std::vector<double>& ResidenceTime() const { return residence_time_; }
+		const std::vector<double>& UA() const { return UA_; }
+		const std::vector<double>& Temperature() const { return temperature_; }
+		const std::vector<double>& Pressure() const { return pressure_; }
+		const std::vector<double>& Diameter() const { return diameter_; }
+		const std::vector<double>& Length() const { return length_; }
+
+		// Changes of the parameters between two solutions (i.e. design loops and sweeps)
+		void SetVolume(const unsigned int k, const double value) { volume_[k] = value; }
+		void SetResidenceTime(const unsigned int k, const double value) { residence_time_[k] = value; }
+		void SetUA(const unsigned int k, const double value) { UA_[k] = value; }
+		void SetTemperature(const unsigned int k, const double value) { temperature_[k] = value; }
+		void SetPressure(const unsigned int k, const double value) { pressure_[k] = value; }
+		void SetStreamMassFlow(const unsigned int s, const double value) { stream_mass_flow_[s] = value; }
+
+	private:
+
+		void LinkInlet(const unsigned int k, const unsigned int j, const int id)
+		{
+			const unsigned int s = StreamIndex(id);
+			if (stream_target_[s] != NoUnit)
+				OpenSMOKE::FatalErrorMessage("Stream " + std::to_string(id) + " is fed to both " + unit_names_[stream_target_[s]] + " and " + unit_names_[k]);
+			stream_target_[s] = static_cast<int>(k);
+			inlet_streams_[inlet_ptr_[k] + j] = s;
+		}
+
+		unsigned int LinkOutlet(const unsigned int k, const unsigned int j, const int id)
+		{
+			const unsigned int s = StreamIndex(id);
+			if (stream_source_[s] != NoUnit)
+				OpenSMOKE::FatalErrorMessage("Stream " + std::to_string(id) + " is produced by both " + unit_names_[stream_source_[s]] + " and " + unit_names_[k]);
+			stream_source_[s] = static_cast<int>(k);
+			outlet_streams_[outlet_ptr_[k] + j] = s;
+			return s;
+		}
+
+		unsigned int StreamIndex(const int id)
+		{
+			std::map<int, unsigned int>::const_iterator it = stream_index_.find(id);
+			if (it != stream_index_.end())
+				return it->second;
+
+			stream_index_[id] = number_of_streams_;
+			stream_ids_.push_back(id);
+			stream_source_.push_back(NoUnit);
+			stream_target_.push_back(NoUnit);
+			stream_phase_.push_back(PHASE_GAS);
+			stream_mass_flow_.push_back(-1.);
+			return number_of_streams_++;
+		}
+
+		void BuildUnitGraph()
+		{
+			std::vector< std::vector<unsigned int> > successors(number_of_units_);
+			std::vector< std::vector<unsigned int> > predecessors(number_of_units_);
+			for (unsigned int s = 0; s < number_of_streams_; s++)
+			{
+				if (stream_source_[s] != NoUnit && stream_target_[s] != NoUnit)
+				{
+					successors[stream_source_[s]].push_back(stream_target_[s]);
+					predecessors[stream_target_[s]].push_back(stream_source_[s]);
+				}
+			}
+
+			FlattenAdjacency(successors, successor_ptr_, successors_);
+			FlattenAdjacency(predecessors, predecessor_ptr_, predecessors_);
+		}
+
+	private:
+
+		unsigned int number_of_units_;
+		unsigned int number_of_streams_;
+
+		std::vector<unsigned int> inlet_ptr_;
+		std::vector<unsigned int> inlet_streams_;
+		std::vector<unsigned int> outlet_ptr_;
+		std::vector<unsigned int> outlet_streams_;
+
+		std::vector<int> stream_ids_;
+		std::vector<int> stream_source_;
+		std::vector<int> stream_target_;
+		std::vector<PhaseType> stream_phase_;
+		std::vector<double> stream_mass_flow_;
+		std::map<int, unsigned int> stream_index_;
+
+		std::vector<unsigned int> successor_ptr_;
+		std::vector<unsigned int> successors_;
+		std::vector<unsigned int> predecessor_ptr_;
+		std::vector<unsigned int> predecessors_;
+
+		std::vector<std::string> unit_names_;
+		std::vector<UnitType> unit_type_;
+		std::vector<EnergyType> unit_energy_;
+		std::vector<double> volume_;
+		std::vector<double> residence_time_;
+		std::vector<double> UA_;
+		std::vector<double> temperature_;
+		std::vector<double> pressure_;
+		std::vector<double> diameter_;
+		std::vector<double> length_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_NETWORKTOPOLOGY_H */
@@ -0,0 +1,534 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+
+#ifndef NETSMOKE_PFRCASCADE_H
+#define NETSMOKE_PFRCASCADE_H
+
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include "Eigen/Dense"
+#include "NetworkTopology.h"
+#include "NetworkTelemetry.h"
+
+namespace NetSMOKE
+{
+	enum PFRModelType { PFR_MODEL_ODE, PFR_MODEL_CASCADE, PFR_MODEL_AUTO };
+
+	inline PFRModelType PFRModelFromString(const std::string& model)
+	{
+		if (model == "ODE")				return PFR_MODEL_ODE;
+		else if (model == "Cascade")	return PFR_MODEL_CASCADE;
+		else if (model == "Auto")		return PFR_MODEL_AUTO;
+		else OpenSMOKE::FatalErrorMessage("Unknown @PFRModel: " + model + " (use ODE, Cascade, Auto)");
+		return PFR_MODEL_ODE;
+	}
+
+	//!  PFR represented as an adaptively refined cascade of PSRs
+	/*!
+		 The reactor volume is split in cells (widths are fractions of the volume) solved in
+		 series, each one as a PSR fed by the previous one. A cascade of N cells is a first
+		 order approximation of the plug flow: the outlet is extrapolated (Richardson) from the
+		 cascade and the one with pairs of adjacent cells merged, and its error is estimated
+		 from the same extrapolation repeated on the next coarser level. Until the estimate
+		 is below the tolerance the number of cells is doubled and the cells are redistributed,
+		 refining where gradients are steep and coarsening where the chemistry is frozen
+		 (see Adapt). The adapted mesh is returned, to be used as starting mesh of the next solution
+		 of the same reactor.
+		 Differences between states are measured as max(|d omega_i|, |dT|/T).
+
+		 Uses the (single lane) kinetics interface of the BatchedPSRSolver:
+		 - unsigned int NumberOfSpecies() const
+		 - void Density(1, const double* T, const double* P, const double* omega, double* rho)
+		 - void SourceTerms(1, const double* T, const double* P, const double* omega, double* S, double* Q)
+		 - void Enthalpies(1, const double* T, double* h)
+		 - void Cp(1, const double* T, const double* P, const double* omega, double* cp)
+	*/
+	template<typename BatchKinetics>
+	class PFRCascade
+	{
+	public:
+
+		PFRCascade(BatchKinetics& kinetics) :
+			kinetics_(kinetics),
+			ns_(kinetics.NumberOfSpecies()),
+			ne_(kinetics.NumberOfSpecies() + 1),
+			tolerance_(1.e-4),
+			initial_cells_(8),
+			max_cells_(256),
+			max_passes_(12),
+			max_iterations_(500),
+			newton_iterations_(0)
+		{
+		}
+
+		void SetTolerance(const double tolerance) { tolerance_ = tolerance; }
+		void SetInitialCells(const unsigned int n) { initial_cells_ = std::max(n, 4u); }
+		void SetMaxCells(const unsigned int n) { max_cells_ = std::max(n, 4u); }
+
+		unsigned int NumberOfSpecies() const { return ns_; }
+
+		//! Newton iterations of all the cells solved (cumulative)
+		unsigned long NumberOfNewtonIterations() const { return newton_iterations_; }
+
+		//! Solves the cascade, returns false if a cell did not converge or if the estimated error
+		//! is still above the tolerance with max_cells_ cells (or after max_passes_ refinements)
+		/*!
+			 isothermal: the temperature is kept equal to T_in (i.e. the reactor temperature)
+			 widths: starting mesh (uniform if empty), on exit the adapted mesh
+			 error: estimated error of the outlet
+			 omega_out and T_out are left untouched if the cascade did not converge
+		*/
+		bool Solve(	const double* omega_in, const double T_in, const double P, const double mass_flow, const double volume,
+					const bool isothermal, std::vector<double>& widths, double* omega_out, double& T_out, double& error)
+		{
+			P_ = P;
+			mass_flow_ = mass_flow;
+			volume_ = volume;
+			isothermal_ = isothermal;
+
+			inlet_.resize(ne_);
+			std::copy(omega_in, omega_in + ns_, inlet_.begin());
+			inlet_[ns_] = T_in;
+
+			if (widths.size() < 4)
+				widths.assign(initial_cells_, 1. / initial_cells_);
+
+			std::vector<double> coarse, coarser, refined;
+			std::vector<double> coarse_states, coarser_states;
+			std::vector<double> outlet(ne_), previous(ne_);
+			bool converged = true;
+			error = 0.;
+			for (unsigned int pass = 0; pass < max_passes_; pass++)
+			{
+				converged = SolveCascade(widths, states_);
+				MergePairs(widths, coarse);
+				MergePairs(coarse, coarser);
+				converged = converged && SolveCascade(coarse, coarse_states) && SolveCascade(coarser, coarser_states);
+				if (converged == false)
+					break;
+
+				// Richardson extrapolation of the outlet (first order in the cell size) on the last two
+				// levels, its error is estimated from the extrapolation on the two coarser levels
+				const double* fine = &states_[(widths.size() - 1) * ne_];
+				const double* middle = &coarse_states[(coarse.size() - 1) * ne_];
+				const double* rough = &coarser_states[(coarser.size() - 1) * ne_];
+				for (unsigned int i = 0; i < ne_; i++)
+				{
+					outlet[i] = 2. * fine[i] - middle[i];
+					previous[i] = 2. * middle[i] - rough[i];
+				}
+				error = Difference(&outlet[0], &previous[0]) / 3.;
+				if (error <= tolerance_ || widths.size() >= max_cells_)
+					break;
+
+				Adapt(widths, refined);
+				widths.swap(refined);
+			}
+
+			if (converged == false || error > tolerance_)
+				return false;
+
+			double sum = 0.;
+			for (unsigned int i = 0; i < ns_; i++)
+			{
+				omega_out[i] = std::max(0., outlet[i]);
+				sum += omega_out[i];
+			}
+			for (unsigned int i = 0; i < ns_; i++)
+				omega_out[i] /= sum;
+			T_out = outlet[ns_];
+			return true;
+		}
+
+	private:
+
+		//! Solves the cells in series, states are stored cell by cell (species and temperature)
+		bool SolveCascade(const std::vector<double>& widths, std::vector<double>& states)
+		{
+			states.resize(widths.size() * ne_);
+			const double* feed = &inlet_[0];
+			for (unsigned int k = 0; k < widths.size(); k++)
+			{
+				double* y = &states[k * ne_];
+				std::copy(feed, feed + ne_, y);
+				if (SolveCell(feed, widths[k] * volume_, y) == false)
+					return false;
+				feed = y;
+			}
+			return true;
+		}
+
+		//! Specific enthalpy of the feed of a cell at its own temperature [J/kg]
+		double FeedEnthalpy(const double* feed)
+		{
+			h_.resize(ns_);
+			kinetics_.Enthalpies(1, &feed[ns_], &h_[0]);
+			double H = 0.;
+			for (unsigned int i = 0; i < ns_; i++)
+				H += feed[i] * h_[i];
+			return H;
+		}
+
+		void Residuals(const double* feed, const double H_feed, const double V, const double* y, double* f, double& tau)
+		{
+			double rho;
+			double Q;
+			S_.resize(ns_);
+			kinetics_.Density(1, &y[ns_], &P_, y, &rho);
+			kinetics_.SourceTerms(1, &y[ns_], &P_, y, &S_[0], &Q);
+
+			tau = rho * V / mass_flow_;
+			for (unsigned int i = 0; i < ns_; i++)
+				f[i] = (feed[i] - y[i]) / tau + S_[i];
+			if (isothermal_ == true)
+				f[ns_] = (inlet_[ns_] - y[ns_]) / tau;
+			else
+			{
+				// Enthalpy balance: (H_feed - sum_i omega_feed,i h_i(T)) / (tau cp) + Q
+				double cp;
+				h_.resize(ns_);
+				kinetics_.Enthalpies(1, &y[ns_], &h_[0]);
+				kinetics_.Cp(1, &y[ns_], &P_, y, &cp);
+				double H = 0.;
+				for (unsigned int i = 0; i < ns_; i++)
+					H += feed[i] * h_[i];
+				f[ns_] = (H_feed - H) / (tau * cp) + Q;
+			}
+		}
+
+		//! Steady state of a single cell with pseudo-transient continuation (as in the BatchedPSRSolver)
+		bool SolveCell(const double* feed, const double V, double* y)
+		{
+			const double eta = 1.e-7;
+			const double absolute_tolerance = 1.e-12;
+			const double relative_tolerance = 1.e-8;
+
+			Eigen::VectorXd f(ne_), fp(ne_), b(ne_);
+			Eigen::MatrixXd J(ne_, ne_);
+			Eigen::PartialPivLU<Eigen::MatrixXd> lu;
+			std::vector<double> yp(y, y + ne_);
+			const double H_feed = (isothermal_ == true) ? 0. : FeedEnthalpy(feed);
+
+			double tau;
+			Residuals(feed, H_feed, V, y, f.data(), tau);
+			// The feed (outlet of the previous cell) is close to the solution: start from one residence time
+			double dt = tau;
+			double norm_old = 0.;
+
+			for (unsigned int k = 0; k < max_iterations_; k++)
+			{
+				bool converged = true;
+				for (unsigned int i = 0; i < ne_ && converged; i++)
+					converged = std::fabs(f(i)) * tau <= absolute_tolerance + relative_tolerance * std::fabs(y[i]);
+				if (converged == true)
+					return true;
+				newton_iterations_++;
+
+				for (unsigned int j = 0; j < ne_; j++)
+				{
+					const double h = eta * std::max(std::fabs(y[j]), (j == ns_) ? 1. : 1.e-10);
+					double tau_p;
+					yp[j] = y[j] + h;
+					Residuals(feed, H_feed, V, &yp[0], fp.data(), tau_p);
+					J.col(j) = (fp - f) / h;
+					yp[j] = y[j];
+				}
+
+				J = -J;
+				J.diagonal().array() += 1. / dt;
+				lu.compute(J);
+				b = lu.solve(f);
+
+				for (unsigned int i = 0; i < ns_; i++)
+					y[i] = std::max(0., y[i] + b(i));
+				y[ns_] += b(ns_);
+				std::copy(y, y + ne_, yp.begin());
+
+				// Switched evolution relaxation, at least doubling the time step while the residuals decrease
+				double norm = 0.;
+				for (unsigned int i = 0; i < ne_; i++)
+					norm = std::max(norm, std::fabs(f(i)) / (absolute_tolerance + relative_tolerance * std::fabs(y[i])));
+				if (norm_old > 0.)
+					dt *= (norm < norm_old) ? std::min(10., std::max(2., norm_old / norm)) : std::max(0.1, norm_old / norm);
+				dt = std::min(dt, 1.e10 * tau);
+				norm_old = norm;
+
+				Residuals(feed, H_feed, V, y, f.data(), tau);
+			}
+			return false;
+		}
+
+		double Difference(const double* a, const double* b) const
+		{
+			double d = std::fabs(a[ns_] - b[ns_]) / std::max(a[ns_], 1.);
+			for (unsigned int i = 0; i < ns_; i++)
+				d = std::max(d, std::fabs(a[i] - b[i]));
+			return d;
+		}
+
+		static void MergePairs(const std::vector<double>& widths, std::vector<double>& coarse)
+		{
+			coarse.clear();
+			for (unsigned int k = 0; k < widths.size(); k += 2)
+				coarse.push_back(widths[k] + ((k + 1 < widths.size()) ? widths[k + 1] : 0.));
+		}
+
+		//! Doubles the cells, distributing them so that every cell has the same share of 1 + |d state/dx| / mean
+		/*!
+			 Cells are concentrated where the state changes steeply and are removed where the
+			 chemistry is frozen. Since the mesh follows a single mapping, merging pairs of cells
+			 gives the same mapping with half the cells, as required by the extrapolation.
+		*/
+		void Adapt(const std::vector<double>& widths, std::vector<double>& refined) const
+		{
+			const unsigned int n = static_cast<unsigned int>(widths.size());
+			std::vector<double> monitor(n);
+			double mean = 0.;
+			for (unsigned int k = 0; k < n; k++)
+			{
+				monitor[k] = Difference(&states_[k * ne_], (k == 0) ? &inlet_[0] : &states_[(k - 1) * ne_]) / widths[k];
+				mean += monitor[k] * widths[k];
+			}
+			double total = 0.;
+			for (unsigned int k = 0; k < n; k++)
+			{
+				monitor[k] = 1. + ((mean > 0.) ? monitor[k] / mean : 0.);
+				total += monitor[k] * widths[k];
+			}
+
+			const unsigned int m = std::max(4u, (std::min(2 * n, max_cells_) / 4) * 4);
+			refined.resize(m);
+
+			// Boundaries at equal increments of the integral of the (piecewise constant) monitor
+			unsigned int k = 0;
+			double x = 0.;					// left boundary of old cell k
+			double integral = 0.;			// integral of the monitor up to x
+			double last = 0.;				// last boundary placed
+			for (unsigned int j = 1; j < m; j++)
+			{
+				const double target = total * j / m;
+				while (k + 1 < n && integral + monitor[k] * widths[k] < target)
+				{
+					integral += monitor[k] * widths[k];
+					x += widths[k];
+					k++;
+				}
+				const double boundary = std::min(1., x + (target - integral) / monitor[k]);
+				refined[j - 1] = boundary - last;
+				last = boundary;
+			}
+			refined[m - 1] = 1. - last;
+		}
+
+	private:
+
+		BatchKinetics& kinetics_;
+		unsigned int ns_;
+		unsigned int ne_;
+
+		double tolerance_;
+		unsigned int initial_cells_;
+		unsigned int max_cells_;
+		unsigned int max_passes_;
+		unsigned int max_iterations_;
+		unsigned long newton_iterations_;
+
+		double P_;
+		double mass_flow_;
+		double volume_;
+		bool isothermal_;
+		std::vector<double> inlet_;
+		std::vector<double> states_;
+		std::vector<double> S_;
+		std::vector<double> h_;
+	};
+
+	//!  Choice between the ODE integration and the PSR cascade of each PFR
+	/*!
+		 In Auto mode, the first solution of every PFR (and then one every revalidation_interval
+		 solutions) is computed with both models: the cascade is chosen if its outlet differs
+		 from the ODE one less than the tolerance and it was faster; otherwise the ODE is used.
+		 The result of the ODE is returned when both are computed. PFRs with heat exchange are
+		 always integrated as ODEs. Every unit has its own state, so different PFRs can be
+		 solved concurrently.
+
+		 The Integrator (i.e. the stiff ODE solver configured through @OdeParameters) must provide
+			bool operator()(const double* omega_in, double T_in, double P, double mass_flow, double volume,
+							double* omega_out, double& T_out)
+		 The Cascade must provide NumberOfNewtonIterations() (see PFRCascade).
+	*/
+	class PFRModelSelector
+	{
+	public:
+
+		PFRModelSelector(const unsigned int number_of_units, const PFRModelType mode, const double tolerance, const unsigned int revalidation_interval = 50) :
+			mode_(mode),
+			tolerance_(tolerance),
+			revalidation_interval_(revalidation_interval),
+			units_(number_of_units),
+			telemetry_(nullptr)
+		{
+		}
+
+		//! Telemetry receiving the statistics of every PFR (null: none); Newton iterations are the ones of the cascade cells,
+		//! each one with its own Jacobian and factorization
+		void SetTelemetry(NetworkTelemetry* telemetry) { telemetry_ = telemetry; }
+
+		template<typename Cascade, typename Integrator>
+		bool Solve(	const unsigned int unit, const EnergyType energy, Cascade& cascade, Integrator& ode,
+					const double* omega_in, const double T_in, const double P, const double mass_flow, const double volume,
+					double* omega_out, double& T_out)
+		{
+			NetworkTelemetry::ScopedUnitTimer timer(telemetry_, unit);
+			const unsigned long iterations = cascade.NumberOfNewtonIterations();
+
+			const bool success = SolveModels(unit, energy, cascade, ode, omega_in, T_in, P, mass_flow, volume, omega_out, T_out);
+
+			if (telemetry_ != nullptr)
+			{
+				UnitCounters& counters = telemetry_->Local(unit);
+				const unsigned long n = cascade.NumberOfNewtonIterations() - iterations;
+				counters.newton_iterations += n;
+				counters.jacobian_evaluations += n;
+				counters.factorizations += n;
+				if (success == false)
+					counters.failures++;
+			}
+			return success;
+		}
+
+		//! Model used by the last solution of unit (PFR_MODEL_AUTO if not solved yet)
+		PFRModelType Model(const unsigned int unit) const { return units_[unit].model; }
+
+		//! Number of cells of the adapted cascade of unit
+		unsigned int NumberOfCells(const unsigned int unit) const { return static_cast<unsigned int>(units_[unit].widths.size()); }
+
+		void Summary(std::ostream& out, const NetworkTopology& topology) const
+		{
+			out << std::endl;
+			out << "--------------------------------------------------------------------" << std::endl;
+			out << " PFR models" << std::endl;
+			out << "--------------------------------------------------------------------" << std::endl;
+			for (unsigned int k = 0; k < units_.size(); k++)
+			{
+				const UnitState& state = units_[k];
+				if (topology.Type()[k] != UNIT_PFR || state.model == PFR_MODEL_AUTO)
+					continue;
+				out << " * " << topology.UnitNames()[k] << ": " << ((state.model == PFR_MODEL_CASCADE) ? "Cascade" : "ODE");
+				if (state.widths.empty() == false)
+					out << " (" << state.widths.size() << " cells, estimated error " << state.error << ")";
+				if (state.ode_time > 0.)
+					out << " ODE " << state.ode_time << " s, cascade " << state.cascade_time << " s, difference " << state.difference;
+				out << std::endl;
+			}
+			out << "--------------------------------------------------------------------" << std::endl;
+		}
+
+	private:
+
+		template<typename Cascade, typename Integrator>
+		bool SolveModels(	const unsigned int unit, const EnergyType energy, Cascade& cascade, Integrator& ode,
+							const double* omega_in, const double T_in, const double P, const double mass_flow, const double volume,
+							double* omega_out, double& T_out)
+		{
+			UnitState& state = units_[unit];
+			if (mode_ == PFR_MODEL_ODE || energy == ENERGY_HEATEXCHANGE)
+			{
+				state.model = PFR_MODEL_ODE;
+				return ode(omega_in, T_in, P, mass_flow, volume, omega_out, T_out);
+			}
+
+			const bool isothermal = (energy == ENERGY_ISOTHERMAL);
+			const bool compare = (mode_ == PFR_MODEL_AUTO) && (state.model == PFR_MODEL_AUTO || state.calls >= revalidation_interval_);
+			if (compare == false)
+			{
+				if (mode_ == PFR_MODEL_CASCADE)
+					state.model = PFR_MODEL_CASCADE;
+				state.calls++;
+				if (state.model == PFR_MODEL_ODE)
+					return ode(omega_in, T_in, P, mass_flow, volume, omega_out, T_out);
+				if (cascade.Solve(omega_in, T_in, P, mass_flow, volume, isothermal, state.widths, omega_out, T_out, state.error) == true)
+					return true;
+
+				// A cell of the cascade did not converge or the cascade is not accurate enough (state.error
+				// above the tolerance with the maximum number of cells): the ODE integration is the fallback
+				return ode(omega_in, T_in, P, mass_flow, volume, omega_out, T_out);
+			}
+
+			// Both models: the ODE solution is the reference
+			const unsigned int ns = cascade.NumberOfSpecies();
+			std::vector<double> omega_cascade(ns);
+			double T_cascade = 0.;
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			const bool cascade_ok = cascade.Solve(omega_in, T_in, P, mass_flow, volume, isothermal, state.widths, &omega_cascade[0], T_cascade, state.error);
+			state.cascade_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			const bool ode_ok = ode(omega_in, T_in, P, mass_flow, volume, omega_out, T_out);
+			state.ode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			// The outlets can be compared only if both models succeeded
+			double difference = std::numeric_limits<double>::infinity();
+			if (cascade_ok == true && ode_ok == true)
+			{
+				difference = std::fabs(T_cascade - T_out) / std::max(T_out, 1.);
+				for (unsigned int i = 0; i < ns; i++)
+					difference = std::max(difference, std::fabs(omega_cascade[i] - omega_out[i]));
+			}
+			state.difference = difference;
+
+			state.model = (cascade_ok && ode_ok && difference <= tolerance_ && state.cascade_time < state.ode_time) ? PFR_MODEL_CASCADE : PFR_MODEL_ODE;
+			state.calls = 0;
+
+			if (ode_ok == false && cascade_ok == true)
+			{
+				std::copy(omega_cascade.begin(), omega_cascade.end(), omega_out);
+				T_out = T_cascade;
+				state.model = PFR_MODEL_CASCADE;
+			}
+			return ode_ok || cascade_ok;
+		}
+
+		struct UnitState
+		{
+			UnitState() : model(PFR_MODEL_AUTO), calls(0), error(0.), difference(0.), ode_time(0.), cascade_time(0.) {}
+
+			PFRModelType model;
+			unsigned int calls;
+			std::vector<double> widths;
+			double error;
+			double difference;
+			double ode_time;
+			double cascade_time;
+		};
+
+		PFRModelType mode_;
+		double tolerance_;
+		unsigned int revalidation_interval_;
+		std::vector<UnitState> units_;
+		NetworkTelemetry* telemetry_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_PFRCASCADE_H */
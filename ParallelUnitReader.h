@@ -0,0 +1,154 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+
+#ifndef NETSMOKE_PARALLELUNITREADER_H
+#define NETSMOKE_PARALLELUNITREADER_H
+
+#include <vector>
+#include <string>
+#include <exception>
+#include <algorithm>
+#include "dictionary/OpenSMOKE_Dictionary.h"
+#include "Grammar_NetSMOKE_Reactors.h"
+#include "Grammar_NetSMOKE_PhaseSplitters.h"
+#include "Grammar_NetSMOKE_ReactorBlocks.h"
+#include "ReadErrors.h"
+#include "WorkStealingThreadPool.h"
+
+namespace NetSMOKE
+{
+	//!  Concurrent reading of independent unit dictionaries
+	/*!
+		 The dictionaries are split in contiguous chunks (a few per worker, for load balance);
+		 every chunk is read by a single task into its own buffer with the usual reader
+		 (i.e. GetReactorsDataFromDictionary), so that validation and unit conversions run in
+		 parallel, and the buffers are appended to data in chunk order. The result is identical
+		 to the sequential reading in declaration order.
+		 The dictionaries must be resolved by the caller (the dictionary manager is not accessed
+		 concurrently), with their grammar already set: the grammar checks of OpenSMOKE terminate
+		 the program on error and must run on the calling thread. Every dictionary is read by one
+		 task only.
+		 Inside the tasks ReadErrorMessage throws instead of terminating the program: an error
+		 stops its chunk and is recorded, and after all the tasks are completed the first error
+		 in declaration order is reported on the calling thread.
+		 Reader: void operator()(OpenSMOKE::OpenSMOKE_Dictionary&, std::vector<T>&)
+	*/
+	template<typename T, typename Reader>
+	void ReadDictionariesInParallel(WorkStealingThreadPool& pool, const std::vector<OpenSMOKE::OpenSMOKE_Dictionary*>& dictionaries,
+									Reader read, std::vector<T>& data)
+	{
+		const unsigned int n = static_cast<unsigned int>(dictionaries.size());
+		if (n == 0)
+			return;
+
+		const unsigned int chunks = std::min(n, 4 * pool.NumberOfThreads());
+		std::vector< std::vector<T> > buffers(chunks);
+		std::vector<std::string> errors(chunks);
+		for (unsigned int c = 0; c < chunks; c++)
+		{
+			const unsigned int first = static_cast<unsigned int>((static_cast<unsigned long long>(n) * c) / chunks);
+			const unsigned int last = static_cast<unsigned int>((static_cast<unsigned long long>(n) * (c + 1)) / chunks);
+			std::vector<T>& buffer = buffers[c];
+			std::string& error = errors[c];
+			pool.Submit([&dictionaries, &read, &buffer, &error, first, last]()
+			{
+				ThrowReadErrorsGuard guard;
+				buffer.reserve(last - first);
+				for (unsigned int k = first; k < last && error.empty() == true; k++)
+				{
+					const std::string where = "Error while reading dictionary " + std::to_string(k + 1) + " of " + std::to_string(dictionaries.size());
+					try
+					{
+						read(*dictionaries[k], buffer);
+					}
+					catch (const std::exception& e)
+					{
+						error = where + ": " + e.what();
+					}
+					catch (...)
+					{
+						error = where;
+					}
+				}
+			});
+		}
+		pool.WaitAll();
+
+		for (unsigned int c = 0; c < chunks; c++)
+			if (errors[c].empty() == false)
+				OpenSMOKE::FatalErrorMessage(errors[c]);
+
+		size_t size = data.size();
+		for (unsigned int c = 0; c < chunks; c++)
+			size += buffers[c].size();
+		data.reserve(size);
+		for (unsigned int c = 0; c < chunks; c++)
+			data.insert(data.end(), buffers[c].begin(), buffers[c].end());
+	}
+
+	//! Reads the @Reactors dictionaries (in declaration order) and appends them to UnitsData
+	inline void ReadReactorsInParallel(WorkStealingThreadPool& pool, const std::vector<OpenSMOKE::OpenSMOKE_Dictionary*>& dictionaries,
+										std::vector<NetSMOKE::UnitInfo>& UnitsData)
+	{
+		for (unsigned int k = 0; k < dictionaries.size(); k++)
+		{
+			Grammar_NetSMOKE_Reactors grammar_reactors;
+			dictionaries[k]->SetGrammar(grammar_reactors);
+		}
+
+		ReadDictionariesInParallel(pool, dictionaries, [](OpenSMOKE::OpenSMOKE_Dictionary& dictionary, std::vector<NetSMOKE::UnitInfo>& buffer)
+		{
+			GetReactorsDataFromDictionary(dictionary, buffer);
+		}, UnitsData);
+	}
+
+	//! Reads the @PhaseSplitters dictionaries (in declaration order) and appends them to UnitsData
+	inline void ReadPhaseSplittersInParallel(WorkStealingThreadPool& pool, const std::vector<OpenSMOKE::OpenSMOKE_Dictionary*>& dictionaries,
+											std::vector<NetSMOKE::UnitInfo>& UnitsData)
+	{
+		for (unsigned int k = 0; k < dictionaries.size(); k++)
+		{
+			Grammar_NetSMOKE_PhaseSplitters grammar_phase_splitters;
+			dictionaries[k]->SetGrammar(grammar_phase_splitters);
+		}
+
+		ReadDictionariesInParallel(pool, dictionaries, [](OpenSMOKE::OpenSMOKE_Dictionary& dictionary, std::vector<NetSMOKE::UnitInfo>& buffer)
+		{
+			GetPhaseSplitterDataFromDictionary(dictionary, buffer);
+		}, UnitsData);
+	}
+
+	//! Reads the @ReactorBlocks dictionaries, including their units and flows files
+	inline void ReadReactorBlocksInParallel(WorkStealingThreadPool& pool, const std::vector<OpenSMOKE::OpenSMOKE_Dictionary*>& dictionaries,
+											std::vector<NetSMOKE::ReactorBlock>& ReactorBlocks)
+	{
+		for (unsigned int k = 0; k < dictionaries.size(); k++)
+		{
+			Grammar_NetSMOKE_ReactorBlocks grammar_reactor_blocks;
+			dictionaries[k]->SetGrammar(grammar_reactor_blocks);
+		}
+
+		ReadDictionariesInParallel(pool, dictionaries, [](OpenSMOKE::OpenSMOKE_Dictionary& dictionary, std::vector<NetSMOKE::ReactorBlock>& buffer)
+		{
+			GetReactorBlockDataFromDictionary(dictionary, buffer, false);
+		}, ReactorBlocks);
+	}
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_PARALLELUNITREADER_H */
@@ -0,0 +1,249 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_PARAMETERSWEEP_H
+#define NETSMOKE_PARAMETERSWEEP_H
+
+#include <vector>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <chrono>
+#include <utility>
+#include "StreamStateArena.h"
+#include "WorkStealingThreadPool.h"
+#include "NetworkTelemetry.h"
+
+namespace NetSMOKE
+{
+	//! Inlet state of one case of a sweep
+	struct SweepCase
+	{
+		double temperature;				// [K]
+		double pressure;				// [Pa]
+		double equivalence_ratio;		// -1 if the composition is not given through an equivalence ratio
+		unsigned int composition;		// index of the inlet composition (i.e. the equivalence ratio) in the list of the caller
+	};
+
+	//! Cases of the full factorial design: temperatures x pressures x compositions
+	/*!
+		 compositions are the states returned by the vector overload of GetGasStatusFromDictionary,
+		 one per equivalence ratio (equivalence_ratios may be empty if not used).
+	*/
+	inline void BuildSweepCases(const std::vector<double>& temperatures, const std::vector<double>& pressures,
+								const unsigned int number_of_compositions, const std::vector<double>& equivalence_ratios,
+								std::vector<SweepCase>& cases)
+	{
+		cases.clear();
+		for (unsigned int i = 0; i < temperatures.size(); i++)
+			for (unsigned int j = 0; j < pressures.size(); j++)
+				for (unsigned int k = 0; k < number_of_compositions; k++)
+				{
+					SweepCase c;
+					c.temperature = temperatures[i];
+					c.pressure = pressures[j];
+					c.equivalence_ratio = equivalence_ratios.empty() ? -1. : equivalence_ratios[k];
+					c.composition = k;
+					cases.push_back(c);
+				}
+	}
+
+	//!  Concurrent solution of the same network for many inlet states
+	/*!
+		 All the cases share the network and the kinetic maps (loaded once by the caller) and
+		 are solved by the workers of the pool. Every case starts from the solution of the
+		 nearest case already solved, measured in (T/1000 K, ln P, equivalence ratio); the cases
+		 are processed along a nearest-neighbour chain starting from the case closest to the
+		 centre of the design, so that a close solved neighbour is usually available.
+
+		 The CaseSolver must provide
+			bool operator()(const SweepCase& c, StreamStateArena& state, bool warm_start, int worker)
+		 which solves the network for case c starting from state and leaves the solution in it.
+		 worker (0 ... NumberOfThreads-1) selects the per-thread work objects (e.g. the copies
+		 of the kinetic maps with their internal buffers).
+	*/
+	class ParameterSweep
+	{
+	public:
+
+		ParameterSweep(const std::vector<SweepCase>& cases, const StreamStateArena& cold_state) :
+			cases_(cases),
+			cold_state_(cold_state),
+			telemetry_(nullptr)
+		{
+			BuildOrder();
+		}
+
+		//! Telemetry receiving wall time, convergence and warm start of every case (null: none)
+		void SetTelemetry(NetworkTelemetry* telemetry) { telemetry_ = telemetry; }
+
+		template<typename CaseSolver>
+		void Run(WorkStealingThreadPool& pool, CaseSolver& solve)
+		{
+			const unsigned int n = NumberOfCases();
+			solutions_.assign(n, StreamStateArena());
+			converged_.assign(n, 0);
+			warm_start_from_.assign(n, -1);
+			solved_.clear();
+			next_ = 1;
+			if (n == 0)
+				return;
+
+			// The first case is solved alone (cold start), then the workers share the remaining ones
+			pool.Submit([this, &pool, &solve]()
+			{
+				SolveCase(order_[0], solve, pool.CurrentWorker());
+
+				for (unsigned int t = 0; t < pool.NumberOfThreads(); t++)
+					pool.Submit([this, &pool, &solve]()
+					{
+						for (;;)
+						{
+							const unsigned int position = next_++;
+							if (position >= order_.size())
+								break;
+							SolveCase(order_[position], solve, pool.CurrentWorker());
+						}
+					});
+			});
+
+			pool.WaitAll();
+		}
+
+		unsigned int NumberOfCases() const { return static_cast<unsigned int>(cases_.size()); }
+		const SweepCase& Case(const unsigned int k) const { return cases_[k]; }
+
+		const StreamStateArena& Solution(const unsigned int k) const { return solutions_[k]; }
+		bool Converged(const unsigned int k) const { return converged_[k] != 0; }
+
+		//! Case used as initial guess for case k (-1 if cold start)
+		int WarmStartedFrom(const unsigned int k) const { return warm_start_from_[k]; }
+
+	private:
+
+		double Distance(const unsigned int a, const unsigned int b) const
+		{
+			const SweepCase& ca = cases_[a];
+			const SweepCase& cb = cases_[b];
+			const double dT = (ca.temperature - cb.temperature) / 1000.;
+			const double dP = std::log(ca.pressure / cb.pressure);
+			const double dphi = (ca.equivalence_ratio >= 0. && cb.equivalence_ratio >= 0.) ? ca.equivalence_ratio - cb.equivalence_ratio :
+								(ca.composition == cb.composition ? 0. : 1.);
+			return dT * dT + dP * dP + dphi * dphi;
+		}
+
+		//! Nearest-neighbour chain starting from the case closest to the centre of the design
+		void BuildOrder()
+		{
+			const unsigned int n = NumberOfCases();
+			order_.clear();
+			if (n == 0)
+				return;
+
+			double T = 0., lnP = 0., phi = 0.;
+			for (unsigned int k = 0; k < n; k++)
+			{
+				T += cases_[k].temperature / n;
+				lnP += std::log(cases_[k].pressure) / n;
+				phi += cases_[k].equivalence_ratio / n;
+			}
+
+			unsigned int current = 0;
+			double best = std::numeric_limits<double>::max();
+			for (unsigned int k = 0; k < n; k++)
+			{
+				const double dT = (cases_[k].temperature - T) / 1000.;
+				const double dP = std::log(cases_[k].pressure) - lnP;
+				const double dphi = cases_[k].equivalence_ratio - phi;
+				const double d = dT * dT + dP * dP + dphi * dphi;
+				if (d < best)
+				{
+					best = d;
+					current = k;
+				}
+			}
+
+			std::vector<char> visited(n, 0);
+			for (unsigned int i = 0; i < n; i++)
+			{
+				order_.push_back(current);
+				visited[current] = 1;
+
+				best = std::numeric_limits<double>::max();
+				for (unsigned int k = 0; k < n; k++)
+					if (visited[k] == 0 && Distance(current, k) < best)
+					{
+						best = Distance(current, k);
+						current = k;
+					}
+			}
+		}
+
+		template<typename CaseSolver>
+		void SolveCase(const unsigned int k, CaseSolver& solve, const int worker)
+		{
+			// Nearest solved case (its solution is not modified anymore)
+			int neighbour = -1;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				double best = std::numeric_limits<double>::max();
+				for (unsigned int i = 0; i < solved_.size(); i++)
+				{
+					const double d = Distance(k, solved_[i]);
+					if (d < best)
+					{
+						best = d;
+						neighbour = static_cast<int>(solved_[i]);
+					}
+				}
+			}
+
+			StreamStateArena state = (neighbour >= 0) ? solutions_[neighbour] : cold_state_;
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			const bool converged = solve(cases_[k], state, neighbour >= 0, worker);
+			if (telemetry_ != nullptr)
+				telemetry_->RecordSweepCase(k, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), converged, neighbour);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			std::swap(solutions_[k], state);
+			converged_[k] = converged ? 1 : 0;
+			warm_start_from_[k] = neighbour;
+			if (converged == true)
+				solved_.push_back(k);
+		}
+
+	private:
+
+		std::vector<SweepCase> cases_;
+		const StreamStateArena& cold_state_;
+		std::vector<unsigned int> order_;
+
+		std::vector<StreamStateArena> solutions_;
+		std::vector<char> converged_;
+		std::vector<int> warm_start_from_;
+
+		std::mutex mutex_;
+		std::vector<unsigned int> solved_;
+		std::atomic<unsigned int> next_;
+
+		NetworkTelemetry* telemetry_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_PARAMETERSWEEP_H */
@@ -0,0 +1,60 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_READERRORS_H
+#define NETSMOKE_READERRORS_H
+
+#include <string>
+#include <stdexcept>
+#include "dictionary/OpenSMOKE_Dictionary.h"
+
+namespace NetSMOKE
+{
+	//! True on the threads reading dictionaries in parallel (see ReadDictionariesInParallel)
+	inline bool& ThrowReadErrors()
+	{
+		static thread_local bool throw_read_errors = false;
+		return throw_read_errors;
+	}
+
+	//!  Reports an error found in the input
+	/*!
+		 Same as OpenSMOKE::FatalErrorMessage, which terminates the program, unless the dictionary
+		 is read by a worker thread: the error is then thrown as a std::runtime_error and reported
+		 on the calling thread once all the readers are completed.
+	*/
+	inline void ReadErrorMessage(const std::string& message)
+	{
+		if (ThrowReadErrors() == true)
+			throw std::runtime_error(message);
+		OpenSMOKE::FatalErrorMessage(message);
+	}
+
+	//! Errors are thrown by ReadErrorMessage while the guard is alive (on the current thread)
+	class ThrowReadErrorsGuard
+	{
+	public:
+		ThrowReadErrorsGuard() : previous_(ThrowReadErrors()) { ThrowReadErrors() = true; }
+		~ThrowReadErrorsGuard() { ThrowReadErrors() = previous_; }
+
+	private:
+		bool previous_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_READERRORS_H */
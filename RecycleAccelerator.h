@@ -0,0 +1,230 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_RECYCLEACCELERATOR_H
+#define NETSMOKE_RECYCLEACCELERATOR_H
+
+#include <vector>
+#include <deque>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include "Eigen/Dense"
+#include "dictionary/OpenSMOKE_Dictionary.h"
+#include "NetworkTelemetry.h"
+
+namespace NetSMOKE
+{
+	enum RecycleAccelerationType { RECYCLE_SUCCESSIVE_SUBSTITUTION, RECYCLE_WEGSTEIN, RECYCLE_ANDERSON };
+
+	inline RecycleAccelerationType RecycleAccelerationTypeFromString(const std::string& method)
+	{
+		if (method == "SuccessiveSubstitution")		return RECYCLE_SUCCESSIVE_SUBSTITUTION;
+		else if (method == "Wegstein")				return RECYCLE_WEGSTEIN;
+		else if (method == "Anderson")				return RECYCLE_ANDERSON;
+		else OpenSMOKE::FatalErrorMessage("Unknown @RecycleAcceleration: " + method + " (use SuccessiveSubstitution, Wegstein, Anderson)");
+		return RECYCLE_SUCCESSIVE_SUBSTITUTION;
+	}
+
+	//!  Convergence acceleration of the tear streams of a recycle block
+	/*!
+		 A sweep of the block maps the guessed tear streams x into the recomputed ones g(x).
+		 Given the pair (x,g) the accelerator replaces x with the next guess:
+		 - successive substitution:	x = x + damping (g - x)
+		 - Wegstein (bounded):		x = x + damping (1-q) (g - x), q = s/(s-1) computed component-wise
+									from the secant slope s of g, clipped to [-5,0]
+		 - Anderson (type II):		least squares combination of the last "history" residuals
+	*/
+	class RecycleAccelerator
+	{
+	public:
+
+		RecycleAccelerator(const RecycleAccelerationType type, const double damping, const unsigned int history) :
+			type_(type),
+			damping_(damping),
+			history_(std::max(1u, history)),
+			iteration_(0),
+			telemetry_(nullptr),
+			block_(0)
+		{
+		}
+
+		//! Telemetry receiving the residual history of recycle block (null: none)
+		void SetTelemetry(NetworkTelemetry* telemetry, const unsigned int block)
+		{
+			telemetry_ = telemetry;
+			block_ = block;
+		}
+
+		//! Residual of a new sweep of the block (see ConvergeRecycle)
+		void RecordIteration(const double residual)
+		{
+			if (telemetry_ != nullptr)
+				telemetry_->RecordRecycleIteration(block_, residual);
+		}
+
+		//! Forgets the previous iterations (e.g. when a recycle block is solved again)
+		void Reset()
+		{
+			iteration_ = 0;
+			x_old_.clear();
+			g_old_.clear();
+			delta_f_.clear();
+			delta_g_.clear();
+		}
+
+		void Update(const std::vector<double>& g, std::vector<double>& x)
+		{
+			if (type_ == RECYCLE_WEGSTEIN && iteration_ > 0)
+				WegsteinUpdate(g, x);
+			else if (type_ == RECYCLE_ANDERSON)
+				AndersonUpdate(g, x);
+			else
+			{
+				x_old_ = x;
+				g_old_ = g;
+				for (unsigned int i = 0; i < x.size(); i++)
+					x[i] += damping_ * (g[i] - x[i]);
+			}
+
+			iteration_++;
+		}
+
+	private:
+
+		void WegsteinUpdate(const std::vector<double>& g, std::vector<double>& x)
+		{
+			const double q_min = -5.;
+			const double q_max = 0.;
+
+			for (unsigned int i = 0; i < x.size(); i++)
+			{
+				const double dx = x[i] - x_old_[i];
+				double q = 0.;
+				if (std::fabs(dx) > 1.e-14 * (1. + std::fabs(x[i])))
+				{
+					const double s = (g[i] - g_old_[i]) / dx;
+					q = (s == 1.) ? q_min : s / (s - 1.);
+					q = std::max(q_min, std::min(q_max, q));
+				}
+
+				x_old_[i] = x[i];
+				g_old_[i] = g[i];
+				x[i] += damping_ * (1. - q) * (g[i] - x[i]);
+			}
+		}
+
+		void AndersonUpdate(const std::vector<double>& g, std::vector<double>& x)
+		{
+			const unsigned int n = static_cast<unsigned int>(x.size());
+			const Eigen::Map<const Eigen::VectorXd> gk(g.data(), n);
+			Eigen::Map<Eigen::VectorXd> xk(x.data(), n);
+			const Eigen::VectorXd fk = gk - xk;
+
+			if (iteration_ > 0)
+			{
+				const Eigen::Map<const Eigen::VectorXd> x_old(x_old_.data(), n);
+				const Eigen::Map<const Eigen::VectorXd> g_old(g_old_.data(), n);
+				delta_f_.push_back(fk - (g_old - x_old));
+				delta_g_.push_back(gk - g_old);
+				if (delta_f_.size() > history_)
+				{
+					delta_f_.pop_front();
+					delta_g_.pop_front();
+				}
+			}
+
+			x_old_ = x;
+			g_old_ = g;
+
+			if (delta_f_.empty() == true)
+			{
+				xk += damping_ * fk;
+				return;
+			}
+
+			const unsigned int m = static_cast<unsigned int>(delta_f_.size());
+			Eigen::MatrixXd F(n, m);
+			Eigen::MatrixXd G(n, m);
+			for (unsigned int j = 0; j < m; j++)
+			{
+				F.col(j) = delta_f_[j];
+				G.col(j) = delta_g_[j];
+			}
+
+			const Eigen::VectorXd gamma = F.colPivHouseholderQr().solve(fk);
+
+			// x = (1-damping) (x - dX gamma) + damping (g - dG gamma), with dX = dG - dF
+			const Eigen::VectorXd x_bar = xk - (G - F) * gamma;
+			const Eigen::VectorXd g_bar = gk - G * gamma;
+			xk = (1. - damping_) * x_bar + damping_ * g_bar;
+		}
+
+	private:
+
+		RecycleAccelerationType type_;
+		double damping_;
+		unsigned int history_;
+		unsigned int iteration_;
+
+		std::vector<double> x_old_;
+		std::vector<double> g_old_;
+		std::deque<Eigen::VectorXd> delta_f_;
+		std::deque<Eigen::VectorXd> delta_g_;
+
+		NetworkTelemetry* telemetry_;
+		unsigned int block_;
+	};
+
+	//! Scaled infinity norm of the tear stream residual g(x) - x (converged below 1, as in the PSR solvers)
+	inline double RecycleResidual(const std::vector<double>& g, const std::vector<double>& x, const double absolute_tolerance, const double relative_tolerance)
+	{
+		double norm = 0.;
+		for (unsigned int i = 0; i < x.size(); i++)
+			norm = std::max(norm, std::fabs(g[i] - x[i]) / (absolute_tolerance + relative_tolerance * std::fabs(x[i])));
+		return norm;
+	}
+
+	//! Converges a recycle block: sweep(x,g) sets the tear streams to x, solves the units of the
+	//! block in sequence and returns the recomputed tear streams in g. Returns the number of sweeps
+	//! (max_iterations+1 if the block did not converge).
+	template<typename Sweep>
+	unsigned int ConvergeRecycle(	Sweep& sweep, std::vector<double>& x, RecycleAccelerator& accelerator,
+									const double absolute_tolerance, const double relative_tolerance, const unsigned int max_iterations)
+	{
+		std::vector<double> g(x.size());
+		accelerator.Reset();
+
+		for (unsigned int k = 1; k <= max_iterations; k++)
+		{
+			sweep(x, g);
+			const double residual = RecycleResidual(g, x, absolute_tolerance, relative_tolerance);
+			accelerator.RecordIteration(residual);
+			if (residual < 1.)
+			{
+				x = g;
+				return k;
+			}
+			accelerator.Update(g, x);
+		}
+
+		return max_iterations + 1;
+	}
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_RECYCLEACCELERATOR_H */
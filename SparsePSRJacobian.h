@@ -0,0 +1,693 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+
+#ifndef NETSMOKE_SPARSEPSRJACOBIAN_H
+#define NETSMOKE_SPARSEPSRJACOBIAN_H
+
+#include <vector>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include "Eigen/Dense"
+#include "Eigen/Sparse"
+#include "Eigen/SparseLU"
+#include "JacobianReuse.h"
+#include "NetworkTelemetry.h"
+#include "dictionary/OpenSMOKE_Dictionary.h"
+
+namespace NetSMOKE
+{
+	enum PSRJacobianType { PSR_JACOBIAN_FINITE_DIFFERENCE, PSR_JACOBIAN_SPARSE_ANALYTICAL };
+
+	inline PSRJacobianType PSRJacobianTypeFromString(const std::string& jacobian)
+	{
+		if (jacobian == "FiniteDifference")			return PSR_JACOBIAN_FINITE_DIFFERENCE;
+		else if (jacobian == "SparseAnalytical")	return PSR_JACOBIAN_SPARSE_ANALYTICAL;
+		else OpenSMOKE::FatalErrorMessage("Unknown @PSRJacobian: " + jacobian + " (use FiniteDifference, SparseAnalytical)");
+		return PSR_JACOBIAN_FINITE_DIFFERENCE;
+	}
+
+	//! Stoichiometry of the kinetic scheme (reactants and products of each reaction, in CSR format)
+	/*!
+		 The reaction orders are assumed equal to the stoichiometric coefficients (mass action),
+		 forward on the reactants and backward on the products.
+	*/
+	struct MechanismStoichiometry
+	{
+		std::vector<double> molecular_weights;			// [kg/kmol]
+
+		std::vector<unsigned int> reactant_ptr;
+		std::vector<unsigned int> reactant_species;
+		std::vector<double> reactant_coefficients;
+
+		std::vector<unsigned int> product_ptr;
+		std::vector<unsigned int> product_species;
+		std::vector<double> product_coefficients;
+
+		MechanismStoichiometry() : reactant_ptr(1, 0), product_ptr(1, 0) {}
+
+		unsigned int NumberOfSpecies() const { return static_cast<unsigned int>(molecular_weights.size()); }
+		unsigned int NumberOfReactions() const { return static_cast<unsigned int>(reactant_ptr.size() - 1); }
+
+		void AddReaction(	const std::vector<unsigned int>& reactants, const std::vector<double>& nu_reactants,
+							const std::vector<unsigned int>& products, const std::vector<double>& nu_products)
+		{
+			reactant_species.insert(reactant_species.end(), reactants.begin(), reactants.end());
+			reactant_coefficients.insert(reactant_coefficients.end(), nu_reactants.begin(), nu_reactants.end());
+			reactant_ptr.push_back(static_cast<unsigned int>(reactant_species.size()));
+			product_species.insert(product_species.end(), products.begin(), products.end());
+			product_coefficients.insert(product_coefficients.end(), nu_products.begin(), nu_products.end());
+			product_ptr.push_back(static_cast<unsigned int>(product_species.size()));
+		}
+	};
+
+	//!  Sparsity pattern of the PSR Jacobian and map for its analytical assembly
+	/*!
+		 Unknowns are the mass fractions followed by the temperature. Species i depends on
+		 species k only if a reaction involves both (k as reactant or product); the temperature
+		 row and column are dense. For every (i, k, reaction j) the assembly map stores the
+		 position in the compressed (column-major) values and the coefficients of
+			dS_i/domega_k = (MW_i/MW_k) nu_ij (nu'_kj rf_j - nu''_kj rb_j) / c_k
+		 where nu_ij is the net stoichiometric coefficient. The dependence of the density on the
+		 composition (a dense rank-one term) is neglected: it changes only the convergence rate
+		 of the Newton iterations, not their solution.
+		 The pattern depends only on the kinetic scheme and is shared (read-only) by all the
+		 solvers, across reactors and threads.
+	*/
+	class SparseJacobianPattern
+	{
+	public:
+
+		struct AssemblyEntry
+		{
+			unsigned int position;
+			unsigned int reaction;
+			unsigned int species;			// k (column)
+			double forward;					// (MW_i/MW_k) nu_ij nu'_kj
+			double backward;				// (MW_i/MW_k) nu_ij nu''_kj
+		};
+
+		explicit SparseJacobianPattern(const MechanismStoichiometry& stoichiometry) :
+			stoichiometry_(stoichiometry),
+			ns_(stoichiometry.NumberOfSpecies()),
+			ne_(stoichiometry.NumberOfSpecies() + 1)
+		{
+			const MechanismStoichiometry& m = stoichiometry;
+			const unsigned int nr = m.NumberOfReactions();
+
+			// Net stoichiometric coefficients and order of every species in every reaction
+			std::vector< std::vector<unsigned int> > species(nr);
+			std::vector< std::vector<double> > net(nr), forward(nr), backward(nr);
+			for (unsigned int j = 0; j < nr; j++)
+			{
+				for (unsigned int r = m.reactant_ptr[j]; r < m.reactant_ptr[j + 1]; r++)
+					AddCoefficient(m.reactant_species[r], -m.reactant_coefficients[r], m.reactant_coefficients[r], 0., species[j], net[j], forward[j], backward[j]);
+				for (unsigned int p = m.product_ptr[j]; p < m.product_ptr[j + 1]; p++)
+					AddCoefficient(m.product_species[p], m.product_coefficients[p], 0., m.product_coefficients[p], species[j], net[j], forward[j], backward[j]);
+			}
+
+			std::vector<Eigen::Triplet<double> > triplets;
+			for (unsigned int i = 0; i < ne_; i++)
+			{
+				triplets.push_back(Eigen::Triplet<double>(i, i, 0.));
+				triplets.push_back(Eigen::Triplet<double>(i, ns_, 0.));
+				triplets.push_back(Eigen::Triplet<double>(ns_, i, 0.));
+			}
+			for (unsigned int j = 0; j < nr; j++)
+				for (unsigned int a = 0; a < species[j].size(); a++)
+					for (unsigned int b = 0; b < species[j].size(); b++)
+						if (net[j][a] != 0.)
+							triplets.push_back(Eigen::Triplet<double>(species[j][a], species[j][b], 0.));
+
+			matrix_.resize(ne_, ne_);
+			matrix_.setFromTriplets(triplets.begin(), triplets.end());
+			matrix_.makeCompressed();
+
+			for (unsigned int j = 0; j < nr; j++)
+				for (unsigned int a = 0; a < species[j].size(); a++)
+					for (unsigned int b = 0; b < species[j].size(); b++)
+					{
+						const unsigned int i = species[j][a];
+						const unsigned int k = species[j][b];
+						if (net[j][a] == 0. || (forward[j][b] == 0. && backward[j][b] == 0.))
+							continue;
+
+						AssemblyEntry entry;
+						entry.position = Position(i, k);
+						entry.reaction = j;
+						entry.species = k;
+						entry.forward = m.molecular_weights[i] / m.molecular_weights[k] * net[j][a] * forward[j][b];
+						entry.backward = m.molecular_weights[i] / m.molecular_weights[k] * net[j][a] * backward[j][b];
+						entries_.push_back(entry);
+					}
+
+			diagonal_.resize(ne_);
+			temperature_row_.resize(ne_);
+			temperature_column_.resize(ne_);
+			for (unsigned int i = 0; i < ne_; i++)
+			{
+				diagonal_[i] = Position(i, i);
+				temperature_row_[i] = Position(ns_, i);
+				temperature_column_[i] = Position(i, ns_);
+			}
+		}
+
+		unsigned int NumberOfSpecies() const { return ns_; }
+		unsigned int NumberOfEquations() const { return ne_; }
+		unsigned int NumberOfNonZeros() const { return static_cast<unsigned int>(matrix_.nonZeros()); }
+
+		const MechanismStoichiometry& Stoichiometry() const { return stoichiometry_; }
+
+		//! Matrix with the pattern of the Jacobian (values are zero)
+		const Eigen::SparseMatrix<double>& Matrix() const { return matrix_; }
+
+		const std::vector<AssemblyEntry>& Entries() const { return entries_; }
+		const std::vector<unsigned int>& Diagonal() const { return diagonal_; }
+		const std::vector<unsigned int>& TemperatureRow() const { return temperature_row_; }
+		const std::vector<unsigned int>& TemperatureColumn() const { return temperature_column_; }
+
+	private:
+
+		static void AddCoefficient(	const unsigned int k, const double nu, const double order_forward, const double order_backward,
+									std::vector<unsigned int>& species, std::vector<double>& net,
+									std::vector<double>& forward, std::vector<double>& backward)
+		{
+			const unsigned int n = static_cast<unsigned int>(std::find(species.begin(), species.end(), k) - species.begin());
+			if (n == species.size())
+			{
+				species.push_back(k);
+				net.push_back(0.);
+				forward.push_back(0.);
+				backward.push_back(0.);
+			}
+			net[n] += nu;
+			forward[n] += order_forward;
+			backward[n] += order_backward;
+		}
+
+		unsigned int Position(const unsigned int row, const unsigned int column) const
+		{
+			const int* inner = matrix_.innerIndexPtr();
+			const int first = matrix_.outerIndexPtr()[column];
+			const int last = matrix_.outerIndexPtr()[column + 1];
+			return static_cast<unsigned int>(std::lower_bound(inner + first, inner + last, static_cast<int>(row)) - inner);
+		}
+
+	private:
+
+		const MechanismStoichiometry& stoichiometry_;
+		unsigned int ns_;
+		unsigned int ne_;
+
+		Eigen::SparseMatrix<double> matrix_;
+		std::vector<AssemblyEntry> entries_;
+		std::vector<unsigned int> diagonal_;
+		std::vector<unsigned int> temperature_row_;
+		std::vector<unsigned int> temperature_column_;
+	};
+
+	//!  Steady-state PSR solver with the analytical sparse Jacobian
+	/*!
+		 Same formulation of the BatchedPSRSolver (pseudo-transient continuation with switched
+		 evolution relaxation), but the Jacobian is assembled analytically in sparse form from
+		 the forward and backward rates of the reactions (the temperature column by a single
+		 finite difference) and factorized with a sparse LU. The symbolic analysis (ordering
+		 and elimination tree) is computed once, when the solver is built, and reused by all
+		 the reactors solved with it: one solver per thread, all sharing the same pattern.
+		 With a JacobianReusePolicy enabled the Jacobian and its factorization are kept over the
+		 Newton iterations as long as the residuals contract fast enough, and the Jacobian of a
+		 reactor can be seeded from its previous solution (JacobianCache) or from the reactor
+		 solved just before by the same solver, if their states are close.
+
+		 The MechanismKinetics class must provide (single reactor):
+		 - double Density(T, P, const double* omega)										[kg/m3]
+		 - void ReactionRates(T, P, const double* c, double* rf, double* rb)				[kmol/m3/s]
+		 - void Enthalpies(T, double* h)													[J/kg]
+		 - double Cp(T, P, const double* omega)												[J/kg/K]
+	*/
+	template<typename MechanismKinetics>
+	class SparsePSRSolver
+	{
+	public:
+
+		SparsePSRSolver(MechanismKinetics& kinetics, const SparseJacobianPattern& pattern) :
+			kinetics_(kinetics),
+			pattern_(pattern),
+			ns_(pattern.NumberOfSpecies()),
+			ne_(pattern.NumberOfEquations()),
+			nr_(pattern.Stoichiometry().NumberOfReactions()),
+			max_iterations_(500),
+			absolute_tolerance_(1.e-12),
+			relative_tolerance_(1.e-7),
+			has_jacobian_(false),
+			telemetry_(nullptr),
+			jacobian_evaluations_(0),
+			jacobian_reuses_(0),
+			factorizations_(0),
+			factorization_reuses_(0)
+		{
+			A_ = pattern.Matrix();
+			lu_.analyzePattern(A_);
+
+			c_.resize(ns_);
+			rf_.resize(nr_);
+			rb_.resize(nr_);
+			h_.resize(ns_);
+			S_.resize(ns_);
+			f_.resize(ne_);
+			fp_.resize(ne_);
+			dy_.resize(ne_);
+			yp_.resize(ne_);
+			jacobian_.resize(A_.nonZeros());
+			y_jacobian_.resize(ne_);
+		}
+
+		void SetMaxIterations(const unsigned int n) { max_iterations_ = n; }
+		void SetTolerances(const double absolute, const double relative) { absolute_tolerance_ = absolute; relative_tolerance_ = relative; }
+		void SetReusePolicy(const JacobianReusePolicy& policy) { policy_ = policy; }
+
+		//! Unit index of the reactors not belonging to the network (nothing is reported to the telemetry)
+		static const unsigned int NoReactor = static_cast<unsigned int>(-1);
+
+		//! Telemetry receiving the statistics of the reactors solved with a unit index (null: none)
+		void SetTelemetry(NetworkTelemetry* telemetry) { telemetry_ = telemetry; }
+
+		//! Statistics of this solver (cumulative over all the reactors solved); reuses are counted per Newton iteration
+		unsigned long NumberOfJacobianEvaluations() const { return jacobian_evaluations_; }
+		unsigned long NumberOfJacobianReuses() const { return jacobian_reuses_; }
+		unsigned long NumberOfFactorizations() const { return factorizations_; }
+		unsigned long NumberOfFactorizationReuses() const { return factorization_reuses_; }
+
+		//! Solves the PSR, y (mass fractions and temperature) is the initial guess and the solution
+		/*!
+			 tau > 0: residence time, otherwise computed from volume (rho V / mass_flow)
+			 T_set > 0: isothermal reactor at T_set, otherwise adiabatic
+		*/
+		bool Solve(	const double* omega_in, const double T_in, const double P, const double mass_flow,
+					const double volume, const double tau, const double T_set, double* y)
+		{
+			return Solve(omega_in, T_in, P, mass_flow, volume, tau, T_set, y, nullptr, NoReactor);
+		}
+
+		//! As above, with the Jacobian of reactor unit seeded from and stored in the cache (if not null)
+		//! and the statistics of the unit reported to the telemetry (if set)
+		bool Solve(	const double* omega_in, const double T_in, const double P, const double mass_flow,
+					const double volume, const double tau, const double T_set, double* y,
+					JacobianCache* cache, const unsigned int unit)
+		{
+			NetworkTelemetry* telemetry = (unit != NoReactor) ? telemetry_ : nullptr;
+			NetworkTelemetry::ScopedUnitTimer timer(telemetry, unit);
+			const unsigned long jacobian_evaluations = jacobian_evaluations_;
+			const unsigned long jacobian_reuses = jacobian_reuses_;
+			const unsigned long factorizations = factorizations_;
+			const unsigned long factorization_reuses = factorization_reuses_;
+			unsigned int iterations = 0;
+
+			SetInputs(omega_in, T_in, P, mass_flow, volume, tau, T_set);
+
+			double tau_l = Residuals(y, &f_[0]);
+			double dt = 1.e-3 * tau_l;
+			double norm_old = 0.;
+
+			bool refresh = (policy_.enabled == false || SeedJacobian(y, cache, unit) == false);
+			bool factorized = false;
+			double dt_factorized = 0.;
+			unsigned int age = 0;
+
+			for (unsigned int k = 0; k < max_iterations_; k++)
+			{
+				if (Converged(y, tau_l) == true)
+					break;
+				iterations++;
+
+				if (refresh == true || policy_.enabled == false || age >= policy_.max_age)
+				{
+					Jacobian(y);
+					refresh = false;
+					factorized = false;
+					age = 0;
+				}
+				else
+					jacobian_reuses_++;
+
+				// Factorized again if the pseudo-time step changed, unless I/dt is negligible in both matrices
+				const bool dt_changed = (dt > policy_.max_dt_ratio * dt_factorized || dt * policy_.max_dt_ratio < dt_factorized) &&
+										std::min(dt, dt_factorized) < 1.e3 * tau_l;
+				if (factorized == false || policy_.enabled == false || dt_changed == true)
+				{
+					Shift(tau_l, dt);
+					lu_.factorize(A_);
+					factorizations_++;
+					if (lu_.info() != Eigen::Success)
+					{
+						dt *= 0.1;
+						refresh = true;
+						factorized = false;
+						continue;
+					}
+					factorized = true;
+					dt_factorized = dt;
+				}
+				else
+					factorization_reuses_++;
+
+				dy_ = lu_.solve(Eigen::Map<const Eigen::VectorXd>(&f_[0], ne_));
+				for (unsigned int i = 0; i < ns_; i++)
+					y[i] = std::max(0., y[i] + dy_(i));
+				y[ns_] += dy_(ns_);
+
+				double norm = 0.;
+				for (unsigned int i = 0; i < ne_; i++)
+					norm = std::max(norm, std::fabs(f_[i]) / (absolute_tolerance_ + relative_tolerance_ * std::fabs(y[i])));
+				// An old Jacobian that no longer gives a fast contraction is evaluated again
+				if (age > 0 && norm_old > 0. && norm > policy_.max_convergence_rate * norm_old)
+					refresh = true;
+				// Switched evolution relaxation, at least doubling the time step while the residuals decrease
+				if (norm_old > 0.)
+					dt *= (norm < norm_old) ? std::min(10., std::max(2., norm_old / norm)) : std::max(0.1, norm_old / norm);
+				dt = std::min(dt, 1.e10 * tau_l);
+				norm_old = norm;
+				age++;
+
+				tau_l = Residuals(y, &f_[0]);
+			}
+
+			const bool converged = Converged(y, tau_l);
+			if (policy_.enabled == true && cache != nullptr && converged == true)
+				cache->Store(unit, &y_jacobian_[0], &jacobian_[0]);
+
+			if (telemetry != nullptr)
+			{
+				UnitCounters& counters = telemetry->Local(unit);
+				counters.newton_iterations += iterations;
+				counters.jacobian_evaluations += jacobian_evaluations_ - jacobian_evaluations;
+				counters.jacobian_reuses += jacobian_reuses_ - jacobian_reuses;
+				counters.factorizations += factorizations_ - factorizations;
+				counters.factorization_reuses += factorization_reuses_ - factorization_reuses;
+				if (converged == false)
+					counters.failures++;
+			}
+			return converged;
+		}
+
+		//! Sensitivities of the solution to the inputs x = (omega_in, T_in, ln P, ln tau): dy/dx = -(dF/dy)^-1 dF/dx
+		/*!
+			 y must be the solution of Solve with the same inputs. Both dF/dy and dF/dx are obtained
+			 by finite differences of the residuals at y (the Jacobian used by the Newton iterations
+			 neglects the dependence of density, residence time and third bodies on the state, good
+			 enough for convergence but not for the derivatives): no reactor is solved again.
+			 dydx: (ns+1) x (ns+3), column major. If tau <= 0 the residence time is changed through
+			 the volume.
+		*/
+		bool Sensitivities(	const double* omega_in, const double T_in, const double P, const double mass_flow,
+							const double volume, const double tau, const double T_set, const double* y, double* dydx)
+		{
+			SetInputs(omega_in, T_in, P, mass_flow, volume, tau, T_set);
+			Residuals(y, &f_[0]);
+
+			// dF/dy (dense, the density couples all the unknowns)
+			Eigen::MatrixXd dFdy(ne_, ne_);
+			std::copy(y, y + ne_, yp_.begin());
+			for (unsigned int j = 0; j < ne_; j++)
+			{
+				const double step = 1.e-8 * std::max(std::fabs(y[j]), (j < ns_) ? 1.e-3 : 1.);
+				yp_[j] = y[j] + step;
+				Residuals(&yp_[0], &fp_[0]);
+				for (unsigned int i = 0; i < ne_; i++)
+					dFdy(i, j) = (fp_[i] - f_[i]) / step;
+				yp_[j] = y[j];
+			}
+			Eigen::FullPivLU<Eigen::MatrixXd> lu(dFdy);
+			factorizations_++;
+			if (lu.isInvertible() == false)
+				return false;
+
+			const unsigned int nx = ns_ + 3;
+			const double h = 1.e-6;
+			Eigen::MatrixXd dFdx(ne_, nx);
+			std::vector<double> omega(omega_in, omega_in + ns_);
+			for (unsigned int j = 0; j < nx; j++)
+			{
+				double step = h;
+				if (j < ns_)
+				{
+					omega[j] += h;
+					SetInputs(&omega[0], T_in, P, mass_flow, volume, tau, T_set);
+				}
+				else if (j == ns_)
+				{
+					step = h * T_in;
+					SetInputs(omega_in, T_in + step, P, mass_flow, volume, tau, T_set);
+				}
+				else if (j == ns_ + 1)
+					SetInputs(omega_in, T_in, P * std::exp(h), mass_flow, volume, tau, T_set);
+				else if (tau > 0.)
+					SetInputs(omega_in, T_in, P, mass_flow, volume, tau * std::exp(h), T_set);
+				else
+					SetInputs(omega_in, T_in, P, mass_flow, volume * std::exp(h), tau, T_set);
+
+				Residuals(y, &fp_[0]);
+				for (unsigned int i = 0; i < ne_; i++)
+					dFdx(i, j) = (fp_[i] - f_[i]) / step;
+				if (j < ns_)
+					omega[j] = omega_in[j];
+			}
+			SetInputs(omega_in, T_in, P, mass_flow, volume, tau, T_set);
+
+			Eigen::Map<Eigen::MatrixXd>(dydx, ne_, nx) = -lu.solve(dFdx);
+			return true;
+		}
+
+	private:
+
+		void SetInputs(	const double* omega_in, const double T_in, const double P, const double mass_flow,
+						const double volume, const double tau, const double T_set)
+		{
+			omega_in_ = omega_in;
+			T_in_ = T_in;
+			P_ = P;
+			mass_flow_ = mass_flow;
+			volume_ = volume;
+			tau_ = tau;
+			T_set_ = T_set;
+
+			// Specific enthalpy of the feed at the inlet temperature [J/kg]
+			H_in_ = 0.;
+			if (T_set_ <= 0.)
+			{
+				kinetics_.Enthalpies(T_in_, &h_[0]);
+				for (unsigned int i = 0; i < ns_; i++)
+					H_in_ += omega_in_[i] * h_[i];
+			}
+		}
+
+		//! Residuals (as in the BatchedPSRSolver), returns the residence time
+		double Residuals(const double* y, double* f)
+		{
+			const std::vector<double>& mw = pattern_.Stoichiometry().molecular_weights;
+			const double T = y[ns_];
+			const double rho = kinetics_.Density(T, P_, y);
+			const double tau = (tau_ > 0.) ? tau_ : rho * volume_ / mass_flow_;
+
+			for (unsigned int i = 0; i < ns_; i++)
+				c_[i] = rho * y[i] / mw[i];
+			kinetics_.ReactionRates(T, P_, &c_[0], &rf_[0], &rb_[0]);
+			ProductionRates(rho);
+
+			for (unsigned int i = 0; i < ns_; i++)
+				f[i] = (omega_in_[i] - y[i]) / tau + S_[i];
+
+			if (T_set_ > 0.)
+				f[ns_] = (T_set_ - T) / tau;
+			else
+			{
+				// Enthalpy balance: (H_in - sum_i omega_in,i h_i(T)) / tau + Q, divided by cp
+				kinetics_.Enthalpies(T, &h_[0]);
+				double Q = 0.;
+				double H_feed = 0.;
+				for (unsigned int i = 0; i < ns_; i++)
+				{
+					Q -= h_[i] * S_[i];
+					H_feed += omega_in_[i] * h_[i];
+				}
+				f[ns_] = ((H_in_ - H_feed) / tau + Q) / kinetics_.Cp(T, P_, y);
+			}
+			return tau;
+		}
+
+		//! S_i = MW_i sum_j nu_ij (rf_j - rb_j) / rho
+		void ProductionRates(const double rho)
+		{
+			const MechanismStoichiometry& m = pattern_.Stoichiometry();
+			std::fill(S_.begin(), S_.end(), 0.);
+			for (unsigned int j = 0; j < nr_; j++)
+			{
+				const double r = rf_[j] - rb_[j];
+				for (unsigned int a = m.reactant_ptr[j]; a < m.reactant_ptr[j + 1]; a++)
+					S_[m.reactant_species[a]] -= m.reactant_coefficients[a] * r;
+				for (unsigned int a = m.product_ptr[j]; a < m.product_ptr[j + 1]; a++)
+					S_[m.product_species[a]] += m.product_coefficients[a] * r;
+			}
+			for (unsigned int i = 0; i < ns_; i++)
+				S_[i] *= m.molecular_weights[i] / rho;
+		}
+
+		//! Jacobian of the reactions (species block analytical, temperature column by finite difference, f_ holds the residuals at y)
+		void Jacobian(const double* y)
+		{
+			double* values = &jacobian_[0];
+			std::fill(jacobian_.begin(), jacobian_.end(), 0.);
+			std::copy(y, y + ne_, y_jacobian_.begin());
+			has_jacobian_ = true;
+			jacobian_evaluations_++;
+
+			// Rates at the current state (concentrations bounded away from zero for the derivatives)
+			const std::vector<double>& mw = pattern_.Stoichiometry().molecular_weights;
+			const double T = y[ns_];
+			const double rho = kinetics_.Density(T, P_, y);
+			double c_total = 0.;
+			for (unsigned int i = 0; i < ns_; i++)
+				c_total += rho * y[i] / mw[i];
+			const double c_min = 1.e-20 * std::max(c_total, 1.e-30);
+			for (unsigned int i = 0; i < ns_; i++)
+				c_[i] = std::max(rho * y[i] / mw[i], c_min);
+			kinetics_.ReactionRates(T, P_, &c_[0], &rf_[0], &rb_[0]);
+
+			const std::vector<SparseJacobianPattern::AssemblyEntry>& entries = pattern_.Entries();
+			for (unsigned int e = 0; e < entries.size(); e++)
+			{
+				const SparseJacobianPattern::AssemblyEntry& entry = entries[e];
+				values[entry.position] += (entry.forward * rf_[entry.reaction] - entry.backward * rb_[entry.reaction]) / c_[entry.species];
+			}
+
+			// Energy row: dQ/domega_k = -sum_i h_i dS_i/domega_k / cp
+			if (T_set_ <= 0.)
+			{
+				kinetics_.Enthalpies(T, &h_[0]);
+				const double cp = kinetics_.Cp(T, P_, y);
+				const int* outer = A_.outerIndexPtr();
+				const int* inner = A_.innerIndexPtr();
+				const std::vector<unsigned int>& row = pattern_.TemperatureRow();
+				for (unsigned int k = 0; k < ns_; k++)
+				{
+					double sum = 0.;
+					for (int p = outer[k]; p < outer[k + 1]; p++)
+						if (static_cast<unsigned int>(inner[p]) < ns_)
+							sum += h_[inner[p]] * values[p];
+					values[row[k]] = -sum / cp;
+				}
+			}
+
+			// Temperature column
+			{
+				const double h = 1.e-7 * std::max(std::fabs(T), 1.);
+				std::copy(y, y + ne_, yp_.begin());
+				yp_[ns_] += h;
+				Residuals(&yp_[0], &fp_[0]);
+				const std::vector<unsigned int>& column = pattern_.TemperatureColumn();
+				for (unsigned int i = 0; i < ne_; i++)
+					values[column[i]] = (fp_[i] - f_[i]) / h;
+			}
+		}
+
+		//! A = I/dt - J, with the outflow terms of the current residence time
+		void Shift(const double tau, const double dt)
+		{
+			double* values = A_.valuePtr();
+			for (unsigned int p = 0; p < jacobian_.size(); p++)
+				values[p] = -jacobian_[p];
+
+			const std::vector<unsigned int>& diagonal = pattern_.Diagonal();
+			for (unsigned int i = 0; i < ns_; i++)
+				values[diagonal[i]] += 1. / tau;
+			for (unsigned int i = 0; i < ne_; i++)
+				values[diagonal[i]] += 1. / dt;
+		}
+
+		//! Jacobian of the previous solution of the same reactor or of the last reactor solved, if close to y
+		bool SeedJacobian(const double* y, const JacobianCache* cache, const unsigned int unit)
+		{
+			bool seeded = false;
+			if (cache != nullptr)
+				seeded = cache->Lookup(unit, y, policy_.similarity, &y_jacobian_[0], &jacobian_[0]);
+			if (seeded == false && has_jacobian_ == true)
+				seeded = (StateDistance(y, &y_jacobian_[0], ns_) <= policy_.similarity);
+			if (seeded == true)
+				has_jacobian_ = true;
+			return seeded;
+		}
+
+		//! Change of the unknowns over one residence time below the tolerances (never for a non-finite or non-positive temperature)
+		bool Converged(const double* y, const double tau) const
+		{
+			if (!(y[ns_] > 0.))
+				return false;
+			for (unsigned int i = 0; i < ne_; i++)
+				if (!(std::fabs(f_[i]) * tau <= absolute_tolerance_ + relative_tolerance_ * std::fabs(y[i])))
+					return false;
+			return true;
+		}
+
+	private:
+
+		MechanismKinetics& kinetics_;
+		const SparseJacobianPattern& pattern_;
+		unsigned int ns_;
+		unsigned int ne_;
+		unsigned int nr_;
+
+		unsigned int max_iterations_;
+		double absolute_tolerance_;
+		double relative_tolerance_;
+
+		Eigen::SparseMatrix<double> A_;
+		Eigen::SparseLU< Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > lu_;
+
+		JacobianReusePolicy policy_;
+		std::vector<double> jacobian_;
+		std::vector<double> y_jacobian_;
+		bool has_jacobian_;
+		NetworkTelemetry* telemetry_;
+		unsigned long jacobian_evaluations_;
+		unsigned long jacobian_reuses_;
+		unsigned long factorizations_;
+		unsigned long factorization_reuses_;
+
+		const double* omega_in_;
+		double T_in_;
+		double H_in_;
+		double P_;
+		double mass_flow_;
+		double volume_;
+		double tau_;
+		double T_set_;
+
+		std::vector<double> c_;
+		std::vector<double> rf_;
+		std::vector<double> rb_;
+		std::vector<double> h_;
+		std::vector<double> S_;
+		std::vector<double> f_;
+		std::vector<double> fp_;
+		std::vector<double> yp_;
+		Eigen::VectorXd dy_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_SPARSEPSRJACOBIAN_H */
@@ -0,0 +1,105 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_SPECIESINDEXMAP_H
+#define NETSMOKE_SPECIESINDEXMAP_H
+
+#include <string>
+#include <vector>
+#include "dictionary/OpenSMOKE_Dictionary.h"
+
+namespace NetSMOKE
+{
+	//!  Hash table from species names to species indices
+	/*!
+		 Built once per kinetic mechanism and shared by all the composition readers.
+		 Open addressing with linear probing in a flat table (load factor below 0.5), so that
+		 a lookup is one hash of the name and, usually, a single string comparison.
+		 The indices are 1-based, as the ones returned by ThermodynamicsMap::IndexOfSpecies,
+		 so that they can be used directly with OpenSMOKEVectorDouble.
+	*/
+	class SpeciesIndexMap
+	{
+	public:
+
+		template<typename Thermodynamics>
+		explicit SpeciesIndexMap(const Thermodynamics& thermodynamicsMapXML) :
+			names_(thermodynamicsMapXML.NamesOfSpecies())
+		{
+			unsigned int capacity = 16;
+			while (capacity < 2 * names_.size())
+				capacity *= 2;
+			mask_ = capacity - 1;
+			slots_.assign(capacity, 0);
+
+			for (unsigned int i = 0; i < names_.size(); i++)
+			{
+				unsigned int j = Hash(names_[i]) & mask_;
+				while (slots_[j] != 0)
+				{
+					if (names_[slots_[j] - 1] == names_[i])
+						OpenSMOKE::FatalErrorMessage("The " + names_[i] + " species is defined twice in the kinetic scheme");
+					j = (j + 1) & mask_;
+				}
+				slots_[j] = i + 1;
+			}
+		}
+
+		unsigned int NumberOfSpecies() const { return static_cast<unsigned int>(names_.size()); }
+
+		unsigned int IndexOfSpecies(const std::string& name) const
+		{
+			for (unsigned int j = Hash(name) & mask_; slots_[j] != 0; j = (j + 1) & mask_)
+				if (names_[slots_[j] - 1] == name)
+					return slots_[j];
+
+			OpenSMOKE::FatalErrorMessage("The " + name + " species is not included in the kinetic scheme");
+			return 0;
+		}
+
+		//! Resolves a whole list of names at once
+		void IndicesOfSpecies(const std::vector<std::string>& names, std::vector<unsigned int>& indices) const
+		{
+			indices.resize(names.size());
+			for (unsigned int i = 0; i < names.size(); i++)
+				indices[i] = IndexOfSpecies(names[i]);
+		}
+
+	private:
+
+		//! 32-bit FNV-1a
+		static unsigned int Hash(const std::string& name)
+		{
+			unsigned int hash = 2166136261u;
+			for (unsigned int i = 0; i < name.size(); i++)
+			{
+				hash ^= static_cast<unsigned char>(name[i]);
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+
+	private:
+
+		std::vector<std::string> names_;
+		std::vector<unsigned int> slots_;		// 0 = empty, otherwise 1-based species index
+		unsigned int mask_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_SPECIESINDEXMAP_H */
@@ -0,0 +1,232 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_STREAMCOMPOSITION_H
+#define NETSMOKE_STREAMCOMPOSITION_H
+
+#include <vector>
+#include <algorithm>
+#include "dictionary/OpenSMOKE_Dictionary.h"
+
+namespace NetSMOKE
+{
+	//!  Mass fractions of a stream, stored sparse or dense
+	/*!
+		 Inlets usually contain a handful of species out of hundreds: they are kept in sparse
+		 form (sorted 0-based species indices + values), and Mix keeps them sparse when the
+		 streams to be mixed are sparse. The composition is promoted to dense when the number
+		 of non-zero species exceeds DensityThreshold of the total (i.e. at the outlet of a reactor).
+		 The network solver (MixerKernel over the StreamStateArena) works on dense rows only:
+		 Mix is meant for the inlets, before they are copied into the arena.
+	*/
+	class StreamComposition
+	{
+	public:
+
+		//! Fraction of non-zero species above which the dense storage is used
+		static double DensityThreshold() { return 0.25; }
+
+		StreamComposition() : number_of_species_(0), dense_(false) {}
+
+		explicit StreamComposition(const unsigned int number_of_species) : number_of_species_(number_of_species), dense_(false) {}
+
+		unsigned int NumberOfSpecies() const { return number_of_species_; }
+		bool IsDense() const { return dense_; }
+		unsigned int NumberOfNonZeros() const { return dense_ ? number_of_species_ : static_cast<unsigned int>(indices_.size()); }
+
+		//! Sparse access (valid only if !IsDense())
+		const std::vector<unsigned int>& Indices() const { return indices_; }
+		const std::vector<double>& Values() const { return values_; }
+
+		//! Dense access (valid only if IsDense())
+		const std::vector<double>& Dense() const { return values_; }
+
+		//! Sets the composition from (unsorted) 0-based species indices and mass fractions
+		void SetSparse(const unsigned int number_of_species, const std::vector<unsigned int>& indices, const std::vector<double>& values)
+		{
+			number_of_species_ = number_of_species;
+			dense_ = false;
+
+			std::vector< std::pair<unsigned int, double> > entries(indices.size());
+			for (unsigned int i = 0; i < indices.size(); i++)
+				entries[i] = std::make_pair(indices[i], values[i]);
+			std::sort(entries.begin(), entries.end());
+
+			indices_.clear();
+			values_.clear();
+			for (unsigned int i = 0; i < entries.size(); i++)
+			{
+				if (indices_.empty() == false && indices_.back() == entries[i].first)
+					values_.back() += entries[i].second;
+				else
+				{
+					indices_.push_back(entries[i].first);
+					values_.push_back(entries[i].second);
+				}
+			}
+
+			PromoteIfNeeded();
+		}
+
+		//! Sets the composition from a dense OpenSMOKE vector (1-based), keeping it sparse if possible
+		void SetFromDense(const OpenSMOKE::OpenSMOKEVectorDouble& omega)
+		{
+			number_of_species_ = static_cast<unsigned int>(omega.Size());
+			dense_ = false;
+			indices_.clear();
+			values_.clear();
+			for (unsigned int i = 0; i < number_of_species_; i++)
+				if (omega[i + 1] != 0.)
+				{
+					indices_.push_back(i);
+					values_.push_back(omega[i + 1]);
+				}
+			PromoteIfNeeded();
+		}
+
+		//! Copies the composition in a dense OpenSMOKE vector (1-based)
+		void GetDense(OpenSMOKE::OpenSMOKEVectorDouble& omega) const
+		{
+			ChangeDimensions(number_of_species_, &omega, true);
+			if (dense_ == true)
+				for (unsigned int i = 0; i < number_of_species_; i++)
+					omega[i + 1] = values_[i];
+			else
+				for (unsigned int k = 0; k < indices_.size(); k++)
+					omega[indices_[k] + 1] = values_[k];
+		}
+
+		void Promote()
+		{
+			if (dense_ == true)
+				return;
+			std::vector<double> dense(number_of_species_, 0.);
+			for (unsigned int k = 0; k < indices_.size(); k++)
+				dense[indices_[k]] = values_[k];
+			values_.swap(dense);
+			indices_.clear();
+			dense_ = true;
+		}
+
+		//! Converts mole fractions into mass fractions (mw: 0-based molecular weights)
+		void MassFractionsFromMoleFractions(const std::vector<double>& mw)
+		{
+			double sum = 0.;
+			if (dense_ == true)
+			{
+				for (unsigned int i = 0; i < number_of_species_; i++)
+					sum += (values_[i] *= mw[i]);
+			}
+			else
+			{
+				for (unsigned int k = 0; k < indices_.size(); k++)
+					sum += (values_[k] *= mw[indices_[k]]);
+			}
+
+			for (unsigned int k = 0; k < values_.size(); k++)
+				values_[k] /= sum;
+		}
+
+		//! Mass-weighted mixing: out = sum_j(m_j omega_j) / sum_j(m_j)
+		static void Mix(const std::vector<const StreamComposition*>& inlets, const std::vector<double>& mass_flows, StreamComposition& out)
+		{
+			if (inlets.empty() == true)
+				OpenSMOKE::FatalErrorMessage("StreamComposition::Mix requires at least one inlet");
+
+			const unsigned int ns = inlets[0]->number_of_species_;
+			double total = 0.;
+			bool dense = false;
+			unsigned int nnz = 0;
+			for (unsigned int j = 0; j < inlets.size(); j++)
+			{
+				total += mass_flows[j];
+				dense = dense || inlets[j]->dense_;
+				nnz += inlets[j]->NumberOfNonZeros();
+			}
+
+			out.number_of_species_ = ns;
+			if (dense == true)
+			{
+				out.dense_ = true;
+				out.indices_.clear();
+				out.values_.assign(ns, 0.);
+				for (unsigned int j = 0; j < inlets.size(); j++)
+				{
+					const double w = mass_flows[j] / total;
+					const StreamComposition& in = *inlets[j];
+					if (in.dense_ == true)
+						for (unsigned int i = 0; i < ns; i++)
+							out.values_[i] += w * in.values_[i];
+					else
+						for (unsigned int k = 0; k < in.indices_.size(); k++)
+							out.values_[in.indices_[k]] += w * in.values_[k];
+				}
+			}
+			else
+			{
+				// k-way merge of the sorted index lists: at every step the smallest index among
+				// the heads of the inlets is taken (mixers have a few inlets, a linear scan is enough)
+				std::vector<double> w(inlets.size());
+				std::vector<unsigned int> head(inlets.size(), 0);
+				for (unsigned int j = 0; j < inlets.size(); j++)
+					w[j] = mass_flows[j] / total;
+
+				out.dense_ = false;
+				out.indices_.clear();
+				out.values_.clear();
+				out.indices_.reserve(nnz);
+				out.values_.reserve(nnz);
+				for (;;)
+				{
+					unsigned int next = ns;
+					for (unsigned int j = 0; j < inlets.size(); j++)
+						if (head[j] < inlets[j]->indices_.size())
+							next = std::min(next, inlets[j]->indices_[head[j]]);
+					if (next == ns)
+						break;
+
+					double value = 0.;
+					for (unsigned int j = 0; j < inlets.size(); j++)
+						if (head[j] < inlets[j]->indices_.size() && inlets[j]->indices_[head[j]] == next)
+							value += w[j] * inlets[j]->values_[head[j]++];
+
+					out.indices_.push_back(next);
+					out.values_.push_back(value);
+				}
+				out.PromoteIfNeeded();
+			}
+		}
+
+	private:
+
+		void PromoteIfNeeded()
+		{
+			if (dense_ == false && indices_.size() > DensityThreshold() * number_of_species_)
+				Promote();
+		}
+
+	private:
+
+		unsigned int number_of_species_;
+		bool dense_;
+		std::vector<unsigned int> indices_;
+		std::vector<double> values_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_STREAMCOMPOSITION_H */
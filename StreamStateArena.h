@@ -0,0 +1,146 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_STREAMSTATEARENA_H
+#define NETSMOKE_STREAMSTATEARENA_H
+
+#include <vector>
+#include <algorithm>
+#include "boost/align/aligned_allocator.hpp"
+#include "NetworkTopology.h"
+
+namespace NetSMOKE
+{
+	//!  State of all the streams of the network in contiguous memory
+	/*!
+		 Mass fractions are stored in a single (rows x species) matrix, with every row aligned
+		 to 64 bytes and padded to a multiple of 8 doubles, so that mixer sweeps read contiguous,
+		 vectorizable memory. Temperature and pressure are stored per row, the mass flow rate
+		 per stream.
+		 The outlets of a Splitter have the same composition, temperature and pressure of its
+		 inlet: they do not own a row, but are views over the row of the inlet stream (also
+		 across chains of splitters). Solving a splitter reduces to setting the outlet flow rates.
+	*/
+	class StreamStateArena
+	{
+	public:
+
+		typedef std::vector< double, boost::alignment::aligned_allocator<double, 64> > AlignedVector;
+
+		StreamStateArena() : number_of_species_(0), stride_(0), number_of_rows_(0) {}
+
+		StreamStateArena(const NetworkTopology& topology, const unsigned int number_of_species)
+		{
+			Setup(topology, number_of_species);
+		}
+
+		void Setup(const NetworkTopology& topology, const unsigned int number_of_species)
+		{
+			const unsigned int ns = topology.NumberOfStreams();
+			const std::vector<int>& source = topology.StreamSource();
+			const std::vector<UnitType>& type = topology.Type();
+
+			number_of_species_ = number_of_species;
+			stride_ = ((number_of_species + 7) / 8) * 8;
+
+			// Splitter outlets point to the row of the inlet of the splitter
+			const unsigned int unassigned = static_cast<unsigned int>(-1);
+			row_.assign(ns, unassigned);
+			number_of_rows_ = 0;
+			for (unsigned int s = 0; s < ns; s++)
+				if (source[s] == NoUnit || type[source[s]] != UNIT_SPLITTER)
+					row_[s] = number_of_rows_++;
+
+			for (unsigned int s = 0; s < ns; s++)
+			{
+				// Walks up the chain of splitters until a stream owning a row is found
+				std::vector<unsigned int> chain;
+				unsigned int t = s;
+				while (row_[t] == unassigned)
+				{
+					chain.push_back(t);
+					const unsigned int splitter = static_cast<unsigned int>(source[t]);
+					if (topology.InletPtr()[splitter + 1] - topology.InletPtr()[splitter] != 1)
+						OpenSMOKE::FatalErrorMessage("Splitter " + topology.UnitNames()[splitter] + " must have exactly one inlet stream");
+					t = topology.InletStreams()[topology.InletPtr()[splitter]];
+					if (chain.size() > ns)
+						OpenSMOKE::FatalErrorMessage("The network contains a loop made only of splitters");
+				}
+				for (unsigned int k = 0; k < chain.size(); k++)
+					row_[chain[k]] = row_[t];
+			}
+
+			mass_fractions_.assign(static_cast<size_t>(number_of_rows_) * stride_, 0.);
+			temperature_.assign(number_of_rows_, 0.);
+			pressure_.assign(number_of_rows_, 0.);
+			// Mass flow rates given in input (i.e. FlowsFile of the reactor blocks), zero if not available
+			mass_flow_.assign(ns, 0.);
+			for (unsigned int s = 0; s < ns; s++)
+				mass_flow_[s] = std::max(0., topology.StreamMassFlow()[s]);
+		}
+
+		unsigned int NumberOfSpecies() const { return number_of_species_; }
+		unsigned int NumberOfStreams() const { return static_cast<unsigned int>(row_.size()); }
+		unsigned int NumberOfRows() const { return number_of_rows_; }
+
+		//! Distance (in doubles) between the compositions of two consecutive rows
+		unsigned int Stride() const { return stride_; }
+
+		unsigned int Row(const unsigned int s) const { return row_[s]; }
+
+		//! True if the stream does not own its composition (outlet of a splitter)
+		bool IsView(const unsigned int s, const NetworkTopology& topology) const
+		{
+			const int source = topology.StreamSource()[s];
+			return (source != NoUnit && topology.Type()[source] == UNIT_SPLITTER);
+		}
+
+		double* MassFractions(const unsigned int s) { return &mass_fractions_[static_cast<size_t>(row_[s]) * stride_]; }
+		const double* MassFractions(const unsigned int s) const { return &mass_fractions_[static_cast<size_t>(row_[s]) * stride_]; }
+
+		double& Temperature(const unsigned int s) { return temperature_[row_[s]]; }
+		double Temperature(const unsigned int s) const { return temperature_[row_[s]]; }
+
+		double& Pressure(const unsigned int s) { return pressure_[row_[s]]; }
+		double Pressure(const unsigned int s) const { return pressure_[row_[s]]; }
+
+		double& MassFlow(const unsigned int s) { return mass_flow_[s]; }
+		double MassFlow(const unsigned int s) const { return mass_flow_[s]; }
+
+		//! Whole storage (i.e. for checkpoints and convergence checks)
+		const AlignedVector& MassFractionsMatrix() const { return mass_fractions_; }
+		const std::vector<double>& TemperatureRows() const { return temperature_; }
+		const std::vector<double>& PressureRows() const { return pressure_; }
+		const std::vector<double>& MassFlows() const { return mass_flow_; }
+
+	private:
+
+		unsigned int number_of_species_;
+		unsigned int stride_;
+		unsigned int number_of_rows_;
+
+		std::vector<unsigned int> row_;
+
+		AlignedVector mass_fractions_;
+		std::vector<double> temperature_;
+		std::vector<double> pressure_;
+		std::vector<double> mass_flow_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_STREAMSTATEARENA_H */
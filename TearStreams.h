@@ -0,0 +1,217 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_TEARSTREAMS_H
+#define NETSMOKE_TEARSTREAMS_H
+
+#include <vector>
+#include <set>
+#include <deque>
+#include <algorithm>
+#include "NetworkTopology.h"
+#include "NetworkSolveOrder.h"
+
+namespace NetSMOKE
+{
+	//!  Tear streams and sweep sequence of the recycle blocks
+	/*!
+		 For every recycle block the units are ordered with the greedy minimum feedback arc set
+		 heuristic of Eades, Lin and Smyth on the stream graph (one arc per internal stream):
+		 sinks are moved to the end of the sequence, sources to the beginning, otherwise the
+		 unit with the largest (outgoing - incoming) arcs is taken. The internal streams going
+		 backwards in the resulting sequence are the tear streams: sweeping the units in that
+		 order, all the other inlet streams are already up to date.
+		 Acyclic blocks have a single unit and no tear streams.
+	*/
+	class TearStreams
+	{
+	public:
+
+		void Select(const NetworkTopology& topology, const NetworkSolveOrder& order)
+		{
+			const unsigned int number_of_blocks = order.NumberOfBlocks();
+			const std::vector<unsigned int>& block_ptr = order.BlockPtr();
+			const std::vector<unsigned int>& block_units = order.BlockUnits();
+			const std::vector<unsigned int>& unit_block = order.UnitBlock();
+
+			sequence_ptr_.assign(number_of_blocks + 1, 0);
+			sequence_.clear();
+			tear_ptr_.assign(number_of_blocks + 1, 0);
+			tears_.clear();
+			is_tear_.assign(topology.NumberOfStreams(), false);
+
+			std::vector<unsigned int> position(topology.NumberOfUnits(), 0);
+			std::vector<unsigned int> local(topology.NumberOfUnits(), 0);
+
+			for (unsigned int b = 0; b < number_of_blocks; b++)
+			{
+				if (order.IsRecycle(b) == false)
+				{
+					sequence_.push_back(block_units[block_ptr[b]]);
+				}
+				else
+				{
+					std::vector<unsigned int> units(block_units.begin() + block_ptr[b], block_units.begin() + block_ptr[b + 1]);
+					std::vector<unsigned int> sequence;
+					OrderBlock(topology, unit_block, b, units, local, sequence);
+
+					for (unsigned int k = 0; k < sequence.size(); k++)
+						position[sequence[k]] = k;
+					sequence_.insert(sequence_.end(), sequence.begin(), sequence.end());
+
+					// Internal streams pointing backwards (or to the unit itself) are torn
+					for (unsigned int k = 0; k < units.size(); k++)
+					{
+						const unsigned int v = units[k];
+						for (unsigned int j = topology.OutletPtr()[v]; j < topology.OutletPtr()[v + 1]; j++)
+						{
+							const unsigned int s = topology.OutletStreams()[j];
+							const int w = topology.StreamTarget()[s];
+							if (w != NoUnit && unit_block[w] == b && position[w] <= position[v])
+							{
+								tears_.push_back(s);
+								is_tear_[s] = true;
+							}
+						}
+					}
+					std::sort(tears_.begin() + tear_ptr_[b], tears_.end());
+				}
+
+				sequence_ptr_[b + 1] = static_cast<unsigned int>(sequence_.size());
+				tear_ptr_[b + 1] = static_cast<unsigned int>(tears_.size());
+			}
+		}
+
+		//! Units of each block in sweep order (CSR)
+		const std::vector<unsigned int>& SequencePtr() const { return sequence_ptr_; }
+		const std::vector<unsigned int>& Sequence() const { return sequence_; }
+
+		//! Tear streams of each block (CSR)
+		const std::vector<unsigned int>& TearPtr() const { return tear_ptr_; }
+		const std::vector<unsigned int>& Tears() const { return tears_; }
+
+		bool IsTear(const unsigned int s) const { return is_tear_[s]; }
+
+		unsigned int NumberOfTears() const { return static_cast<unsigned int>(tears_.size()); }
+
+	private:
+
+		static void OrderBlock(	const NetworkTopology& topology, const std::vector<unsigned int>& unit_block, const unsigned int b,
+								const std::vector<unsigned int>& units, std::vector<unsigned int>& local, std::vector<unsigned int>& sequence)
+		{
+			const unsigned int n = static_cast<unsigned int>(units.size());
+
+			// Local stream graph (arcs between units of the block, self loops excluded)
+			for (unsigned int k = 0; k < n; k++)
+				local[units[k]] = k;
+
+			std::vector< std::vector<unsigned int> > out(n);
+			std::vector< std::vector<unsigned int> > in(n);
+			for (unsigned int k = 0; k < n; k++)
+			{
+				const unsigned int v = units[k];
+				for (unsigned int j = topology.OutletPtr()[v]; j < topology.OutletPtr()[v + 1]; j++)
+				{
+					const int w = topology.StreamTarget()[topology.OutletStreams()[j]];
+					if (w != NoUnit && unit_block[w] == b && static_cast<unsigned int>(w) != v)
+					{
+						out[k].push_back(local[w]);
+						in[local[w]].push_back(k);
+					}
+				}
+			}
+
+			std::vector<int> out_degree(n), in_degree(n);
+			std::set< std::pair<int, unsigned int> > candidates;	// (out - in degree, unit)
+			std::deque<unsigned int> sinks, sources;
+			for (unsigned int k = 0; k < n; k++)
+			{
+				out_degree[k] = static_cast<int>(out[k].size());
+				in_degree[k] = static_cast<int>(in[k].size());
+				candidates.insert(std::make_pair(out_degree[k] - in_degree[k], k));
+				if (out_degree[k] == 0)			sinks.push_back(k);
+				else if (in_degree[k] == 0)		sources.push_back(k);
+			}
+
+			std::vector<bool> removed(n, false);
+			std::vector<unsigned int> head, tail;
+
+			while (candidates.empty() == false)
+			{
+				unsigned int k;
+				if (sinks.empty() == false)
+				{
+					k = sinks.front();
+					sinks.pop_front();
+					if (removed[k] == true)	continue;
+					tail.push_back(k);
+				}
+				else if (sources.empty() == false)
+				{
+					k = sources.front();
+					sources.pop_front();
+					if (removed[k] == true)	continue;
+					head.push_back(k);
+				}
+				else
+				{
+					k = candidates.rbegin()->second;
+					head.push_back(k);
+				}
+
+				removed[k] = true;
+				candidates.erase(std::make_pair(out_degree[k] - in_degree[k], k));
+
+				for (unsigned int j = 0; j < out[k].size(); j++)
+				{
+					const unsigned int w = out[k][j];
+					if (removed[w] == true)	continue;
+					candidates.erase(std::make_pair(out_degree[w] - in_degree[w], w));
+					in_degree[w]--;
+					candidates.insert(std::make_pair(out_degree[w] - in_degree[w], w));
+					if (in_degree[w] == 0)	sources.push_back(w);
+				}
+				for (unsigned int j = 0; j < in[k].size(); j++)
+				{
+					const unsigned int u = in[k][j];
+					if (removed[u] == true)	continue;
+					candidates.erase(std::make_pair(out_degree[u] - in_degree[u], u));
+					out_degree[u]--;
+					candidates.insert(std::make_pair(out_degree[u] - in_degree[u], u));
+					if (out_degree[u] == 0)	sinks.push_back(u);
+				}
+			}
+
+			sequence.clear();
+			for (unsigned int k = 0; k < head.size(); k++)
+				sequence.push_back(units[head[k]]);
+			for (unsigned int k = static_cast<unsigned int>(tail.size()); k > 0; k--)
+				sequence.push_back(units[tail[k - 1]]);
+		}
+
+	private:
+
+		std::vector<unsigned int> sequence_ptr_;
+		std::vector<unsigned int> sequence_;
+		std::vector<unsigned int> tear_ptr_;
+		std::vector<unsigned int> tears_;
+		std::vector<bool> is_tear_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_TEARSTREAMS_H */
@@ -0,0 +1,192 @@
+/*-----------------------------------------------------------------------*\
+|																		  |
+|			 _   _      _    _____ __  __  ____  _  ________         	  |
+|			| \ | |    | |  / ____|  \/  |/ __ \| |/ /  ____|        	  |
+|			|  \| | ___| |_| (___ | \  / | |  | | ' /| |__   			  |
+|			| . ` |/ _ \ __|\___ \| |\/| | |  | |  < |  __|  		  	  |
+|			| |\  |  __/ |_ ____) | |  | | |__| | . \| |____ 		 	  |
+|			|_| \_|\___|\__|_____/|_|  |_|\____/|_|\_\______|		 	  |
+|                                                                         |
+|   Author: Matteo Mensi <matteo.mensi@mail.polimi.it>                    |
+|   CRECK Modeling Group <http://creckmodeling.chem.polimi.it>            |
+|   Department of Chemistry, Materials and Chemical Engineering           |
+|   Politecnico di Milano                                                 |
+|   P.zza Leonardo da Vinci 32, 20133 Milano                              |
+|                                                                         |
+\*-----------------------------------------------------------------------*/
+
+#ifndef NETSMOKE_WORKSTEALINGTHREADPOOL_H
+#define NETSMOKE_WORKSTEALINGTHREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace NetSMOKE
+{
+	//!  Thread pool with one task queue per worker
+	/*!
+		 A worker pushes and pops the tasks it generates at the back of its own queue (so that
+		 a unit is usually solved by the thread which produced its inlet stream) and, when its
+		 queue is empty, steals from the front of the queues of the other workers.
+		 Tasks submitted from outside the pool are distributed round-robin.
+	*/
+	class WorkStealingThreadPool
+	{
+	public:
+
+		explicit WorkStealingThreadPool(const unsigned int number_of_threads) :
+			pending_(0),
+			queued_(0),
+			next_queue_(0),
+			stop_(false)
+		{
+			const unsigned int n = (number_of_threads == 0) ? 1 : number_of_threads;
+			for (unsigned int i = 0; i < n; i++)
+				queues_.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+			for (unsigned int i = 0; i < n; i++)
+				workers_.push_back(std::thread(&WorkStealingThreadPool::WorkerLoop, this, i));
+		}
+
+		~WorkStealingThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(wake_mutex_);
+				stop_ = true;
+			}
+			wake_.notify_all();
+			for (unsigned int i = 0; i < workers_.size(); i++)
+				workers_[i].join();
+		}
+
+		unsigned int NumberOfThreads() const { return static_cast<unsigned int>(workers_.size()); }
+
+		void Submit(const std::function<void()>& task)
+		{
+			const int self = CurrentWorker();
+			const unsigned int i = (self >= 0) ? static_cast<unsigned int>(self) : (next_queue_++ % queues_.size());
+			{
+				std::lock_guard<std::mutex> lock(wake_mutex_);
+				pending_++;
+				{
+					std::lock_guard<std::mutex> queue_lock(queues_[i]->mutex);
+					queues_[i]->tasks.push_back(task);
+				}
+				queued_++;
+			}
+			wake_.notify_one();
+		}
+
+		//! Blocks until every submitted task (including the ones submitted by other tasks) is completed
+		void WaitAll()
+		{
+			std::unique_lock<std::mutex> lock(wake_mutex_);
+			done_.wait(lock, [this] { return pending_ == 0; });
+		}
+
+		//! Index of the worker running on the calling thread (-1 if not a worker of this pool)
+		int CurrentWorker() const
+		{
+			return (CurrentPool() == this) ? CurrentIndex() : -1;
+		}
+
+	private:
+
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque< std::function<void()> > tasks;
+		};
+
+		static const WorkStealingThreadPool*& CurrentPool()
+		{
+			static thread_local const WorkStealingThreadPool* pool = nullptr;
+			return pool;
+		}
+
+		static int& CurrentIndex()
+		{
+			static thread_local int index = -1;
+			return index;
+		}
+
+		bool Pop(const unsigned int i, std::function<void()>& task)
+		{
+			std::lock_guard<std::mutex> lock(queues_[i]->mutex);
+			if (queues_[i]->tasks.empty() == true)
+				return false;
+			task = queues_[i]->tasks.back();
+			queues_[i]->tasks.pop_back();
+			return true;
+		}
+
+		bool Steal(const unsigned int i, std::function<void()>& task)
+		{
+			for (unsigned int k = 1; k < queues_.size(); k++)
+			{
+				WorkerQueue& victim = *queues_[(i + k) % queues_.size()];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (victim.tasks.empty() == false)
+				{
+					task = victim.tasks.front();
+					victim.tasks.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void WorkerLoop(const unsigned int i)
+		{
+			CurrentPool() = this;
+			CurrentIndex() = static_cast<int>(i);
+
+			for (;;)
+			{
+				std::function<void()> task;
+				if (Pop(i, task) == true || Steal(i, task) == true)
+				{
+					{
+						std::lock_guard<std::mutex> lock(wake_mutex_);
+						queued_--;
+					}
+
+					task();
+
+					std::lock_guard<std::mutex> lock(wake_mutex_);
+					if (--pending_ == 0)
+						done_.notify_all();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(wake_mutex_);
+				wake_.wait(lock, [this] { return stop_ == true || queued_ > 0; });
+				if (stop_ == true && queued_ == 0)
+					return;
+			}
+		}
+
+	private:
+
+		std::vector< std::unique_ptr<WorkerQueue> > queues_;
+		std::vector<std::thread> workers_;
+
+		std::mutex wake_mutex_;
+		std::condition_variable wake_;
+		std::condition_variable done_;
+
+		// Guarded by wake_mutex_
+		unsigned int pending_;				// submitted and not completed
+		int queued_;						// submitted and not started
+		std::atomic<unsigned int> next_queue_;
+		bool stop_;
+	};
+
+} // End namespace NetSMOKE
+
+#endif /* NETSMOKE_WORKSTEALINGTHREADPOOL_H */